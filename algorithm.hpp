@@ -0,0 +1,174 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/algorithm.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_ALGORITHM_HPP
+#define MT_ALGORITHM_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include <algorithm>    // for std::for_each, std::transform
+#include <iterator>     // for std::distance
+#include <type_traits>  // for std::enable_if, std::is_same
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+/**
+ *  @brief Apply a function to every element of a sequence.
+ *  @param  begin  A random access iterator.
+ *  @param  end    A random access iterator.
+ *  @param  func   A unary function object.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @return  Nothing.
+ *
+ *  Applies @p func to the result of dereferencing every iterator in the
+ *  range @p [begin,end). Parts of the range are processed by different
+ *  threads, so @p func may be called concurrently and in any order.
+*/
+template<typename RandomAccessIterator, typename Function>
+CONSTEXPR inline void for_each(RandomAccessIterator begin, RandomAccessIterator end, Function func, mt::thread_pool& pool)
+{
+    mt::parallel_for(0, std::distance(begin, end), [begin, &func](size_t from, size_t to) {
+        std::for_each(begin + from, begin + to, func);
+    }, pool);
+}
+
+/**
+ *  @brief Apply a function to every element of a sequence.
+ *  @param  begin  A random access iterator.
+ *  @param  end    A random access iterator.
+ *  @param  func   A unary function object.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used.
+*/
+template<typename RandomAccessIterator, typename Function>
+CONSTEXPR inline void for_each(RandomAccessIterator begin, RandomAccessIterator end, Function func)
+{
+    mt::for_each(begin, end, func, mt::default_pool());
+}
+
+/**
+ *  @brief Perform an operation on a sequence.
+ *  @param  begin    A random access iterator.
+ *  @param  end      A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  op       A unary operator.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Stores op(*i) into the respective position of the destination for every
+ *  iterator @e i in the range @p [begin,end). As std::transform() it may be
+ *  used in place, when @p d_first is @p begin.
+*/
+template<typename RandomAccessIterator, typename OutputIt, typename UnaryOperation>
+CONSTEXPR inline OutputIt transform(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, UnaryOperation op, mt::thread_pool& pool)
+{
+    const size_t size = std::distance(begin, end);
+    mt::parallel_for(0, size, [begin, d_first, &op](size_t from, size_t to) {
+        std::transform(begin + from, begin + to, d_first + from, op);
+    }, pool);
+    return d_first + size;
+}
+
+/**
+ *  @brief Perform an operation on corresponding elements of two sequences.
+ *  @param  begin1   A random access iterator.
+ *  @param  end1     A random access iterator.
+ *  @param  begin2   A random access iterator, the beginning of the second sequence.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  op       A binary operator.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename BinaryOperation>
+CONSTEXPR inline OutputIt transform(RandomAccessIterator1 begin1, RandomAccessIterator1 end1, RandomAccessIterator2 begin2,
+                                    OutputIt d_first, BinaryOperation op, mt::thread_pool& pool)
+{
+    const size_t size = std::distance(begin1, end1);
+    mt::parallel_for(0, size, [begin1, begin2, d_first, &op](size_t from, size_t to) {
+        std::transform(begin1 + from, begin1 + to, begin2 + from, d_first + from, op);
+    }, pool);
+    return d_first + size;
+}
+
+/**
+ *  @brief Perform an operation on corresponding elements of two sequences.
+ *  @param  begin1   A random access iterator.
+ *  @param  end1     A random access iterator.
+ *  @param  begin2   A random access iterator, the beginning of the second sequence.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  op       A binary operator.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but mt::default_pool() is used.
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename BinaryOperation,
+         typename = typename std::enable_if<!std::is_same<typename std::decay<BinaryOperation>::type, mt::thread_pool>::value>::type>
+CONSTEXPR inline OutputIt transform(RandomAccessIterator1 begin1, RandomAccessIterator1 end1, RandomAccessIterator2 begin2,
+                                    OutputIt d_first, BinaryOperation op)
+{
+    return mt::transform(begin1, end1, begin2, d_first, op, mt::default_pool());
+}
+
+/**
+ *  @brief Perform an operation on a sequence.
+ *  @param  begin    A random access iterator.
+ *  @param  end      A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  op       A unary operator.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but mt::default_pool() is used.
+*/
+template<typename RandomAccessIterator, typename OutputIt, typename UnaryOperation>
+CONSTEXPR inline OutputIt transform(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, UnaryOperation op)
+{
+    return mt::transform(begin, end, d_first, op, mt::default_pool());
+}
+
+}
+
+#endif // MT_ALGORITHM_HPP
@@ -0,0 +1,226 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/** @file mt/async.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_ASYNC_HPP
+#define MT_ASYNC_HPP
+
+#include "thread_pool.hpp"
+#include "future.hpp"
+#include "sort.hpp"
+#include "unique.hpp"
+#include <atomic>       // for std::atomic
+#include <functional>   // for std::less, std::equal_to
+#include <iterator>     // for std::iterator_traits
+#include <memory>       // for std::shared_ptr
+#include <stdexcept>    // for std::runtime_error
+#include <type_traits>  // for std::enable_if
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+// Thrown by get() of a result of an operation which has been cancelled
+class operation_cancelled : public std::runtime_error {
+public:
+    operation_cancelled() : std::runtime_error("mt: the operation has been cancelled") {}
+};
+
+/**
+ *  @brief Cooperative cancellation of asynchronous operations.
+ *
+ *  Copies share the same flag. Operations check it when they start, when
+ *  they finish and between their steps, e.g. mt::sort_async() checks it
+ *  at every partition, so a cancelled sort stops soon and leaves the range
+ *  partially sorted. The result of a cancelled operation throws
+ *  mt::operation_cancelled, so its continuations are not called.
+*/
+class cancellation_token {
+public:
+    cancellation_token() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() {
+        flag->store(true, std::memory_order_relaxed);
+    }
+
+    bool is_cancelled() const {
+        return flag->load(std::memory_order_relaxed);
+    }
+
+    void throw_if_cancelled() const {
+        if (is_cancelled()) throw operation_cancelled();
+    }
+
+    // The flag which algorithms check, see mt::sort_tuning::cancelled
+    const std::atomic<bool>* get() const {
+        return flag.get();
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+};
+
+/**
+ *  @brief Sort the elements of a sequence without waiting for it.
+ *  @param  begin  An iterator linked with first element.
+ *  @param  end    Another iterator linked with last element.
+ *  @param  cmp    A comparison functor.
+ *  @param  pool   Thread pool which will be used for sorting.
+ *  @param  token  Token which may cancel the sort.
+ *  @return  A future which is ready when the sequence is sorted.
+ *
+ *  The same as mt::sort(), but the sort is run by a task of @p pool, so the
+ *  caller may prepare the next batch meanwhile. Several batches may be in
+ *  flight on the same pool, continuations chain further steps, e.g.
+ *  @code
+ *  auto done = mt::sort_async(v.begin(), v.end(), pool).then(pool, [&v, &pool] {
+ *      return mt::unique(v.begin(), v.end(), pool);
+ *  }).then(pool, [&v](std::vector<int>::iterator last) { write(v.begin(), last); });
+ *  @endcode
+ *  The sequence must not be touched until the future is ready.
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline mt::future<void> sort_async(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool,
+                                             const cancellation_token& token)
+{
+    mt::thread_pool* _pool = &pool;
+    return pool.submit([begin, end, cmp, _pool, token] {
+        token.throw_if_cancelled();
+        sort_policy::quick_sort policy;
+        policy.tuning.cancelled = token.get();
+        mt::sort(policy, begin, end, cmp, *_pool);
+        token.throw_if_cancelled();
+    });
+}
+
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline mt::future<void> sort_async(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
+{
+    return mt::sort_async(begin, end, cmp, pool, cancellation_token());
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline mt::future<void> sort_async(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool,
+                                             const cancellation_token& token)
+{
+    return mt::sort_async(begin, end, Compare(), pool, token);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline mt::future<void> sort_async(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    return mt::sort_async(begin, end, Compare(), pool, cancellation_token());
+}
+
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline mt::future<void> sort_async(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp)
+{
+    return mt::sort_async(begin, end, cmp, mt::default_pool(), cancellation_token());
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline mt::future<void> sort_async(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    return mt::sort_async(begin, end, mt::default_pool());
+}
+
+/**
+ *  @brief Remove consecutive values from a sequence without waiting for it.
+ *  @param  begin  A forward iterator.
+ *  @param  end    A forward iterator.
+ *  @param  p      A binary predicate.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @param  token  Token which may cancel the operation.
+ *  @return  A future of the end of the resulting sequence.
+ *
+ *  The same as mt::unique(), but it is run by a task of @p pool as
+ *  mt::sort_async() is. The token is checked before and after the parts
+ *  are processed.
+*/
+template<class ForwardIt, class BinaryPredicate>
+CONSTEXPR inline mt::future<ForwardIt> unique_async(ForwardIt begin, ForwardIt end, BinaryPredicate p, mt::thread_pool& pool,
+                                                    const cancellation_token& token)
+{
+    mt::thread_pool* _pool = &pool;
+    return pool.submit([begin, end, p, _pool, token] {
+        token.throw_if_cancelled();
+        const ForwardIt last = mt::unique(begin, end, p, *_pool);
+        token.throw_if_cancelled();
+        return last;
+    });
+}
+
+template<class ForwardIt, class BinaryPredicate>
+CONSTEXPR inline mt::future<ForwardIt> unique_async(ForwardIt begin, ForwardIt end, BinaryPredicate p, mt::thread_pool& pool)
+{
+    return mt::unique_async(begin, end, p, pool, cancellation_token());
+}
+
+template<class ForwardIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline mt::future<ForwardIt> unique_async(ForwardIt begin, ForwardIt end, mt::thread_pool& pool, const cancellation_token& token)
+{
+    return mt::unique_async(begin, end, Pred(), pool, token);
+}
+
+template<class ForwardIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline mt::future<ForwardIt> unique_async(ForwardIt begin, ForwardIt end, mt::thread_pool& pool)
+{
+    return mt::unique_async(begin, end, Pred(), pool, cancellation_token());
+}
+
+template<class ForwardIt, class BinaryPredicate, typename = typename std::enable_if<!std::is_integral<BinaryPredicate>::value>::type>
+CONSTEXPR inline mt::future<ForwardIt> unique_async(ForwardIt begin, ForwardIt end, BinaryPredicate p)
+{
+    return mt::unique_async(begin, end, p, mt::default_pool(), cancellation_token());
+}
+
+template<class ForwardIt>
+CONSTEXPR inline mt::future<ForwardIt> unique_async(ForwardIt begin, ForwardIt end)
+{
+    return mt::unique_async(begin, end, mt::default_pool());
+}
+
+}
+
+#endif // MT_ASYNC_HPP
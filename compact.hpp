@@ -0,0 +1,146 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/compact.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_COMPACT_HPP
+#define MT_COMPACT_HPP
+
+#include "thread_pool.hpp"
+#include <algorithm>    // for std::move, std::min
+#include <iterator>     // for std::iterator_traits, std::make_move_iterator
+#include <memory>       // for std::uninitialized_copy
+#include <vector>       // for std::vector
+
+namespace mt {
+
+namespace detail {
+
+// Offsets [begin, end) of elements which should be kept
+struct compact_range {
+    size_t begin;
+    size_t end;
+};
+
+// Saved elements are constructed by moving in uninitialized memory, so they needn't be default constructible,
+// every range is destroyed if it has been saved
+template<typename T>
+class compact_tails {
+public:
+    compact_tails(const compact_tails&) = delete;
+    compact_tails& operator=(const compact_tails&) = delete;
+
+    compact_tails(scratch_arena& arena, const std::vector<size_t>& tails)
+        : arena(arena), tails(tails), elements(static_cast<T*>(arena.acquire(tails.back() * sizeof(T)))), saved(tails.size() - 1, 0) {}
+
+    ~compact_tails() {
+        for (size_t i = 0; i < saved.size(); i++) {
+            if (!saved[i]) continue;
+            for (T* element = elements + tails[i]; element != elements + tails[i + 1]; ++element) element->~T();
+        }
+        arena.release(elements);
+    }
+
+    template<class RandomIt>
+    void save(size_t range, RandomIt from, RandomIt to) {
+        std::uninitialized_copy(std::make_move_iterator(from), std::make_move_iterator(to), elements + tails[range]);
+        saved[range] = 1;
+    }
+
+    T* begin(size_t range) { return elements + tails[range]; }
+
+private:
+    scratch_arena& arena;
+    const std::vector<size_t>& tails;
+    T* elements;
+    std::vector<char> saved; // not std::vector<bool>, ranges are saved in parallel
+};
+
+/**
+ *  @brief Move several ranges of a sequence to its beginning one after another.
+ *  @param  first   A random access iterator, the beginning of the sequence.
+ *  @param  ranges  Not overlapping ranges of elements to keep, in ascending order.
+ *  @param  pool    Thread pool which will be used for moving.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Every range is moved by its own task. A range is moved to the left by
+ *  the amount of dropped elements before it, so the last of its elements
+ *  may be overwritten by the following ranges before they are read. These
+ *  min(length, shift) elements are saved into a buffer first; the others
+ *  are only overwritten by the range itself.
+*/
+template<class RandomIt>
+inline RandomIt parallel_compact(RandomIt first, const std::vector<compact_range>& ranges, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomIt>::value_type value_type;
+    const size_t ranges_amount = ranges.size();
+    std::vector<size_t> offsets(ranges_amount + 1); // positions of ranges in the result
+    std::vector<size_t> tails(ranges_amount + 1);   // positions of saved elements of ranges in the buffer
+    for (size_t i = 0; i < ranges_amount; i++) {
+        const size_t length = ranges[i].end - ranges[i].begin;
+        offsets[i + 1] = offsets[i] + length;
+        tails[i + 1] = tails[i] + std::min(length, ranges[i].begin - offsets[i]);
+    }
+    if (tails[ranges_amount] == 0) return first + offsets[ranges_amount]; // nothing moves
+
+    compact_tails<value_type> buffer(pool.scratch(), tails);
+    mt::task_group group(pool);
+    for (size_t i = 0; i < ranges_amount; i++) {
+        const size_t tail = tails[i + 1] - tails[i];
+        if (tail == 0) continue;
+        const RandomIt end = first + ranges[i].end;
+        group.run([&buffer, i, end, tail]{ buffer.save(i, end - tail, end); });
+    }
+    group.wait();
+
+    for (size_t i = 0; i < ranges_amount; i++) {
+        if (ranges[i].begin == offsets[i]) continue; // already in place
+        const size_t tail = tails[i + 1] - tails[i];
+        const RandomIt from = first + ranges[i].begin, end = first + ranges[i].end, to = first + offsets[i];
+        value_type* const saved = buffer.begin(i);
+        group.run([from, end, to, tail, saved]{
+            std::move(saved, saved + tail, std::move(from, end - tail, to));
+        });
+    }
+    group.wait();
+    return first + offsets[ranges_amount];
+}
+
+}
+
+}
+
+#endif // MT_COMPACT_HPP
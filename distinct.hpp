@@ -0,0 +1,275 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/** @file mt/distinct.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_DISTINCT_HPP
+#define MT_DISTINCT_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include "compact.hpp"
+#include "scratch_arena.hpp"
+#include <algorithm>    // for std::fill, std::max, std::min
+#include <functional>   // for std::hash, std::equal_to
+#include <iterator>     // for std::iterator_traits
+#include <limits>       // for std::numeric_limits
+#include <vector>       // for std::vector
+#include <stdint.h>
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Hash table of a partition of this amount of elements fits into L2 cache
+static const size_t distinct_partition_size = 0x4000;
+// The scatter misses TLB too often with more partitions
+static const size_t distinct_max_partitions = 0x1000;
+
+// Finalizer of MurmurHash3, std::hash of integers is the identity, so bits are mixed before they are used
+inline uint64_t mix_hash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+template<typename Index>
+struct hashed_index {
+    uint64_t hash;
+    Index index;
+};
+
+// Slot of the hash table of a partition, a part of the hash is kept to compare elements only if it matches
+template<typename Index>
+struct distinct_slot {
+    uint32_t tag;
+    Index index;
+};
+
+/**
+ *  @brief Mark the first occurrences of values of one partition.
+ *  @param  entries  Hashes and indexes of elements of the partition in ascending order of indexes.
+ *  @param  table    Memory for at least 2 * (@p end - @p entries) slots, rounded up to a power of two.
+ *  @param  keep     Flags of elements, they are set for every element of the partition.
+*/
+template<typename Index, typename RandomIt, typename Equal>
+inline void distinct_partition(const hashed_index<Index>* entries, const hashed_index<Index>* end, distinct_slot<Index>* table,
+                               RandomIt first, Equal& equal, char* keep)
+{
+    const Index empty = std::numeric_limits<Index>::max();
+    size_t slots = 16;
+    while (slots < size_t(end - entries) * 2) slots *= 2;
+    const size_t mask = slots - 1;
+    std::fill(table, table + slots, distinct_slot<Index> {0, empty});
+
+    for (; entries != end; ++entries) {
+        const uint32_t tag = uint32_t(entries->hash >> 24);
+        size_t slot = entries->hash & mask;
+        bool found = false;
+        for (; table[slot].index != empty; slot = (slot + 1) & mask) {
+            if (table[slot].tag == tag && equal(first[table[slot].index], first[entries->index])) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) table[slot] = {tag, entries->index};
+        keep[entries->index] = !found;
+    }
+}
+
+/**
+ *  @brief Remove all but the first occurrence of every value of an unsorted sequence.
+ *
+ *  Elements are hashed once, then blocks of the sequence scatter hashes and
+ *  indexes of their elements to partitions by the high bits of the hash
+ *  like a pass of mt::radix_sort() does. Equal elements get to the same
+ *  partition, so every partition is deduplicated by its own task with its
+ *  own small open addressing table, without any synchronization. Indexes
+ *  go to a partition in ascending order, so the first occurrence is the one
+ *  which is kept. Kept elements are moved to the beginning of their blocks,
+ *  and the blocks are joined by detail::parallel_compact().
+*/
+template<typename Index, typename RandomIt, typename Hash, typename Equal>
+inline RandomIt distinct(RandomIt first, RandomIt last, Hash& hash, Equal& equal, mt::thread_pool& pool)
+{
+    const size_t size = std::distance(first, last);
+    if (size < 2) return last;
+
+    size_t partitions = 1, bits = 0;
+    while (partitions < distinct_max_partitions && partitions * distinct_partition_size < size) {
+        partitions *= 2;
+        bits++;
+    }
+    const size_t shift = 64 - bits;
+    const auto partition_of = [shift, bits](uint64_t hash) -> size_t { return bits ? hash >> shift : 0; };
+
+    scratch_arena& arena = pool.scratch();
+    const size_t blocks_amount = detail::parts_amount(size, pool);
+    std::vector<size_t> counts(blocks_amount * partitions);
+    scratch_buffer<uint64_t> hashes(arena, size);
+
+    // Hash and count elements of every partition in every block
+    detail::for_each_part(size, blocks_amount, [&](size_t block, size_t from, size_t to) {
+        size_t* _counts = &counts[block * partitions];
+        for (size_t i = from; i < to; i++) {
+            const uint64_t h = mix_hash(hash(first[i]));
+            hashes[i] = h;
+            _counts[partition_of(h)]++;
+        }
+    }, pool);
+
+    // Exclusive prefix sum in partition-major order
+    std::vector<size_t> partition_begins(partitions + 1);
+    size_t offset = 0;
+    for (size_t p = 0; p < partitions; p++) {
+        partition_begins[p] = offset;
+        for (size_t block = 0; block < blocks_amount; block++) {
+            const size_t count = counts[block * partitions + p];
+            counts[block * partitions + p] = offset;
+            offset += count;
+        }
+    }
+    partition_begins[partitions] = size;
+
+    scratch_buffer<hashed_index<Index>> entries(arena, size);
+    detail::for_each_part(size, blocks_amount, [&](size_t block, size_t from, size_t to) {
+        size_t* offsets = &counts[block * partitions];
+        for (size_t i = from; i < to; i++) {
+            entries[offsets[partition_of(hashes[i])]++] = {hashes[i], Index(i)};
+        }
+    }, pool);
+
+    // Deduplicate partitions, every group of them shares one table
+    scratch_buffer<char> keep(arena, size);
+    mt::parallel_for(0, partitions, [&](size_t from, size_t to) {
+        size_t largest = 0;
+        for (size_t p = from; p < to; p++) largest = std::max(largest, partition_begins[p + 1] - partition_begins[p]);
+        size_t slots = 16;
+        while (slots < largest * 2) slots *= 2;
+        scratch_buffer<distinct_slot<Index>> table(arena, slots);
+        for (size_t p = from; p < to; p++) {
+            distinct_partition(entries.begin() + partition_begins[p], entries.begin() + partition_begins[p + 1],
+                               table.begin(), first, equal, keep.begin());
+        }
+    }, pool, 1);
+
+    // Kept elements are moved to the beginning of their blocks, then blocks are joined
+    std::vector<detail::compact_range> kept(blocks_amount);
+    detail::for_each_part(size, blocks_amount, [&](size_t block, size_t from, size_t to) {
+        size_t _last = from;
+        for (size_t i = from; i < to; i++) {
+            if (!keep[i]) continue;
+            if (i != _last) first[_last] = std::move(first[i]);
+            _last++;
+        }
+        kept[block] = {from, _last};
+    }, pool);
+    return detail::parallel_compact(first, kept, pool);
+}
+
+}
+
+/**
+ *  @brief Remove duplicate values from an unsorted sequence.
+ *  @param  first  A random access iterator.
+ *  @param  last   A random access iterator.
+ *  @param  hash   A hash functor of elements.
+ *  @param  equal  A binary predicate, elements which are equal by it must have equal hashes.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Keeps the first occurrence of every value, kept elements go in their
+ *  original order, so it is the same as unique elements of the sequence
+ *  without sorting it. Unlike mt::sort() followed by mt::unique() it takes
+ *  linear time.
+ *
+ *  Elements are partitioned by their hashes, so every partition fits into
+ *  cache and it is deduplicated by its own task without locks. Temporary
+ *  buffers of about 25 bytes per element are taken from pool.scratch().
+*/
+template<class RandomIt, class Hash, class Equal>
+CONSTEXPR inline RandomIt distinct(RandomIt first, RandomIt last, Hash hash, Equal equal, mt::thread_pool& pool)
+{
+    if (size_t(std::distance(first, last)) < std::numeric_limits<uint32_t>::max()) {
+        return detail::distinct<uint32_t>(first, last, hash, equal, pool);
+    }
+    return detail::distinct<size_t>(first, last, hash, equal, pool);
+}
+
+/**
+ *  @brief Remove duplicate values from an unsorted sequence.
+ *  @param  first  A random access iterator.
+ *  @param  last   A random access iterator.
+ *  @param  hash   A hash functor of elements.
+ *  @param  equal  A binary predicate, elements which are equal by it must have equal hashes.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but mt::default_pool() is used.
+*/
+template<class RandomIt, class Hash, class Equal>
+CONSTEXPR inline RandomIt distinct(RandomIt first, RandomIt last, Hash hash, Equal equal)
+{
+    return mt::distinct(first, last, hash, equal, mt::default_pool());
+}
+
+template<class RandomIt, typename T = typename std::iterator_traits<RandomIt>::value_type>
+CONSTEXPR inline RandomIt distinct(RandomIt first, RandomIt last, mt::thread_pool& pool)
+{
+    return mt::distinct(first, last, std::hash<T>(), std::equal_to<T>(), pool);
+}
+
+template<class RandomIt, typename T = typename std::iterator_traits<RandomIt>::value_type>
+CONSTEXPR inline RandomIt distinct(RandomIt first, RandomIt last)
+{
+    return mt::distinct(first, last, std::hash<T>(), std::equal_to<T>(), mt::default_pool());
+}
+
+}
+
+#endif // MT_DISTINCT_HPP
@@ -0,0 +1,461 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/external_sort.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_EXTERNAL_SORT_HPP
+#define MT_EXTERNAL_SORT_HPP
+
+#include "thread_pool.hpp"
+#include "sort.hpp"
+#include "merge.hpp"
+#include "unique.hpp"
+#include <algorithm>    // for std::upper_bound
+#include <atomic>       // for std::atomic
+#include <cstdio>       // for FILE
+#include <functional>   // for std::less
+#include <future>       // for std::async
+#include <memory>       // for std::unique_ptr
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+#include <type_traits>  // for std::is_trivially_copyable
+#include <utility>      // for std::pair
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+// Default memory for records of mt::external_sort()
+#ifndef MT_EXTERNAL_SORT_MEMORY_BYTES
+#define MT_EXTERNAL_SORT_MEMORY_BYTES 0x10000000
+#endif
+
+namespace mt {
+
+/**
+ *  @brief Parameters of mt::external_sort().
+ *
+ *  Sorted runs are a third of @p memory_bytes each, so that one of them is
+ *  read, one is sorted and one is written at once. Runs are kept in
+ *  @p temp_directory, or in the system temporary directory if it is empty.
+ *  If @p unique is set, only the first of equal records is written.
+*/
+struct external_sort_options {
+    size_t memory_bytes;
+    std::string temp_directory;
+    bool unique;
+
+    external_sort_options() : memory_bytes(MT_EXTERNAL_SORT_MEMORY_BYTES), unique(false) {}
+};
+
+namespace detail {
+
+// Reads of merged runs are not smaller, so a merge of too many runs is done in several passes
+static const size_t external_min_block_bytes = 0x10000;
+
+// Binary file of records, a temporary one is removed when it is closed
+class record_file {
+public:
+    record_file(const record_file&) = delete;
+    record_file& operator=(const record_file&) = delete;
+
+    record_file(const std::string& path, const char* mode) : path(path), temporary(false), file(fopen(path.c_str(), mode)) {
+        if (!file) throw std::runtime_error("mt: can't open " + path);
+    }
+
+    // A new temporary file in @p directory, or in the system temporary directory if it is empty
+    explicit record_file(const std::string& directory) : temporary(true), file(nullptr) {
+        if (directory.empty()) {
+            file = std::tmpfile();
+            if (!file) throw std::runtime_error("mt: can't create a temporary file");
+            return;
+        }
+        static std::atomic<size_t> counter {0};
+        for (size_t attempt = 0; !file && attempt < 100; attempt++) {
+            path = directory + "/mt_external_sort_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + "_" + std::to_string(counter++) + ".tmp";
+            file = fopen(path.c_str(), "w+bx");
+        }
+        if (!file) throw std::runtime_error("mt: can't create a temporary file in " + directory);
+    }
+
+    ~record_file() {
+        fclose(file);
+        if (temporary && !path.empty()) std::remove(path.c_str());
+    }
+
+    // Returns fewer records than @p amount at the end of the file only
+    template<typename T>
+    size_t read(T* to, size_t amount) {
+        const size_t result = fread(to, sizeof(T), amount, file);
+        if (result < amount && ferror(file)) throw std::runtime_error("mt: can't read " + name());
+        return result;
+    }
+
+    template<typename T>
+    void write(const T* from, size_t amount) {
+        if (fwrite(from, sizeof(T), amount, file) != amount) throw std::runtime_error("mt: can't write " + name());
+    }
+
+    // Makes written records available for reading from the beginning
+    void rewind() {
+        if (fflush(file) != 0 || fseek(file, 0, SEEK_SET) != 0) throw std::runtime_error("mt: can't write " + name());
+    }
+
+    size_t size_bytes() {
+        if (fseek(file, 0, SEEK_END) != 0) throw std::runtime_error("mt: can't read " + name());
+        const long result = ftell(file);
+        if (result < 0 || fseek(file, 0, SEEK_SET) != 0) throw std::runtime_error("mt: can't read " + name());
+        return static_cast<size_t>(result);
+    }
+
+private:
+    std::string name() const {
+        return path.empty() ? std::string("a temporary file") : path;
+    }
+
+    std::string path;
+    bool temporary;
+    FILE* file;
+};
+
+// Reading or writing by a task of the pool, which is waited for before buffers of the task are freed, e.g. by an exception
+template<typename R>
+struct io_task {
+    mt::future<R> result;
+
+    ~io_task() {
+        if (result.valid()) result.wait();
+    }
+};
+
+// Sorted run of a merge: the window [position, filled) of current is merged while the next block is read into ahead
+template<typename T>
+struct external_run {
+    record_file* file;
+    mt::thread_pool* pool;
+    std::vector<T> current;
+    std::vector<T> ahead;
+    size_t position;
+    size_t filled;
+    io_task<size_t> reading;
+
+    void read_ahead() {
+        record_file* from = file;
+        T* to = ahead.data();
+        const size_t amount = ahead.size();
+        reading.result = pool->submit([from, to, amount]{ return from->read(to, amount); });
+    }
+
+    // Takes the block which has been read ahead if the window is empty, returns false if the run is over
+    bool refill() {
+        if (position != filled) return true;
+        if (!reading.result.valid()) return false;
+        const size_t amount = reading.result.get();
+        if (amount == 0) return false;
+        current.swap(ahead);
+        position = 0;
+        filled = amount;
+        read_ahead();
+        return true;
+    }
+};
+
+/**
+ *  @brief Merge sorted runs into @p output.
+ *  @return  Amount of written records.
+ *
+ *  Every round merges the windows of all runs up to the smallest last
+ *  element of the windows of runs which are not completely read, so all
+ *  smaller records are already in memory. Windows are merged by
+ *  mt::merge_k() while tasks of the pool read the next blocks and write
+ *  the previous output, so no threads are started by the merge.
+*/
+template<typename T, typename Compare>
+inline size_t merge_runs(const std::vector<record_file*>& inputs, record_file& output, Compare& cmp, mt::thread_pool& pool,
+                         size_t memory_bytes, bool unique)
+{
+    const size_t k = inputs.size();
+    const size_t block_size = std::max<size_t>(memory_bytes / sizeof(T) / (4 * k), 1);
+    std::vector<external_run<T>> runs(k);
+    for (size_t i = 0; i < k; i++) {
+        runs[i].file = inputs[i];
+        runs[i].pool = &pool;
+        runs[i].current.resize(block_size);
+        runs[i].ahead.resize(block_size);
+        runs[i].position = runs[i].filled = 0;
+        runs[i].read_ahead();
+    }
+
+    auto equal = detail::sorted_equal_to(cmp);
+    std::vector<T> outputs[2];
+    size_t output_index = 0;
+    io_task<void> writing;
+    bool has_last = false;
+    T last = T();
+    size_t written = 0;
+    for (;;) {
+        // records which are not bigger than the bound can't be preceded by unread ones
+        const T* bound = nullptr;
+        std::vector<size_t> active;
+        for (size_t i = 0; i < k; i++) {
+            if (!runs[i].refill()) continue;
+            active.push_back(i);
+            const T& back = runs[i].current[runs[i].filled - 1];
+            if (runs[i].reading.result.valid() && (!bound || cmp(back, *bound))) bound = &back;
+        }
+        if (active.empty()) break;
+
+        std::vector<std::pair<const T*, const T*>> windows;
+        size_t size = 0;
+        for (size_t i: active) {
+            const T* from = runs[i].current.data() + runs[i].position;
+            const T* to = runs[i].current.data() + runs[i].filled;
+            if (bound) to = std::upper_bound(from, to, *bound, cmp);
+            windows.push_back(std::make_pair(from, to));
+            size += to - from;
+        }
+
+        std::vector<T>& merged = outputs[output_index];
+        merged.resize(size);
+        mt::merge_k(windows.begin(), windows.end(), merged.begin(), cmp, pool);
+        for (size_t w = 0; w < active.size(); w++) {
+            runs[active[w]].position += windows[w].second - windows[w].first;
+        }
+
+        const T* from = merged.data();
+        size_t amount = size;
+        if (unique) {
+            amount = mt::unique(merged.begin(), merged.end(), equal, pool) - merged.begin();
+            if (has_last && equal(last, *from)) {
+                from++;
+                amount--;
+            }
+            if (amount != 0) {
+                last = from[amount - 1];
+                has_last = true;
+            }
+        }
+
+        if (writing.result.valid()) writing.result.get();
+        writing.result = pool.submit([&output, from, amount]{ output.write(from, amount); });
+        written += amount;
+        output_index ^= 1;
+    }
+    if (writing.result.valid()) writing.result.get();
+    return written;
+}
+
+/**
+ *  @brief Sort records which are returned by @p read into the file @p output.
+ *  @param  read   read(to, amount) copies up to @p amount next records to @p to and returns their amount.
+ *  @param  total  Amount of records which @p read returns.
+ *  @return  Amount of written records.
+*/
+template<typename T, typename Reader, typename Compare>
+inline size_t external_sort(Reader read, size_t total, const std::string& output, Compare& cmp, mt::thread_pool& pool,
+                            const external_sort_options& options)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "mt::external_sort() requires trivially copyable records");
+    const size_t memory_bytes = std::max(options.memory_bytes, 3 * sizeof(T));
+    const size_t chunk_size = std::max<size_t>(std::min(memory_bytes / sizeof(T) / 3, total), 1);
+    auto equal = detail::sorted_equal_to(cmp);
+
+    // Sorted runs: the next chunk is read and the previous one is written while a chunk is sorted
+    std::vector<T> chunks[3];
+    std::vector<std::unique_ptr<record_file>> runs;
+    {
+        chunks[0].resize(chunk_size);
+        std::future<size_t> reading = std::async(std::launch::async, [&read, &chunks, chunk_size]{ return read(chunks[0].data(), chunk_size); });
+        std::future<void> writing;
+        for (size_t current = 0;; current = (current + 1) % 3) {
+            size_t amount = reading.get();
+            if (amount == 0) break;
+            std::vector<T>& chunk = chunks[current];
+            const bool whole = runs.empty() && amount == total;
+            if (!whole) {
+                std::vector<T>& next = chunks[(current + 1) % 3];
+                next.resize(chunk_size);
+                reading = std::async(std::launch::async, [&read, &next, chunk_size]{ return read(next.data(), chunk_size); });
+            }
+            mt::sort(chunk.begin(), chunk.begin() + amount, cmp, pool);
+            if (options.unique) {
+                amount = mt::unique(chunk.begin(), chunk.begin() + amount, equal, pool) - chunk.begin();
+            }
+            if (writing.valid()) writing.get();
+
+            if (whole) {
+                record_file file(output, "wb");
+                file.write(chunk.data(), amount);
+                return amount;
+            }
+            runs.emplace_back(new record_file(options.temp_directory));
+            record_file* run = runs.back().get();
+            const T* data = chunk.data();
+            writing = std::async(std::launch::async, [run, data, amount]{
+                run->write(data, amount);
+                run->rewind();
+            });
+        }
+        if (writing.valid()) writing.get();
+    }
+    for (std::vector<T>& chunk: chunks) std::vector<T>().swap(chunk);
+    if (runs.empty()) {
+        record_file file(output, "wb");
+        return 0;
+    }
+
+    // Too many runs would be read by too small blocks, so they are merged by groups first
+    const size_t fan_in = std::max<size_t>(memory_bytes / (4 * std::max(external_min_block_bytes, sizeof(T))), 2);
+    while (runs.size() > fan_in) {
+        std::vector<std::unique_ptr<record_file>> merged;
+        for (size_t first = 0; first < runs.size(); first += fan_in) {
+            std::vector<record_file*> group;
+            for (size_t i = first; i < std::min(first + fan_in, runs.size()); i++) group.push_back(runs[i].get());
+            merged.emplace_back(new record_file(options.temp_directory));
+            detail::merge_runs<T>(group, *merged.back(), cmp, pool, memory_bytes, options.unique);
+            merged.back()->rewind();
+        }
+        runs.swap(merged);
+    }
+
+    std::vector<record_file*> inputs;
+    for (auto& run: runs) inputs.push_back(run.get());
+    record_file file(output, "wb");
+    const size_t written = detail::merge_runs<T>(inputs, file, cmp, pool, memory_bytes, options.unique);
+    file.rewind();
+    return written;
+}
+
+}
+
+/**
+ *  @brief Sort a binary file of records which may be bigger than memory.
+ *  @param  input    Path of the file of records of type @e T.
+ *  @param  output   Path of the sorted file, it is overwritten.
+ *  @param  cmp      A comparison functor.
+ *  @param  pool     Thread pool which will be used for sorting and merging.
+ *  @param  options  Memory limit, place of temporary files and deduplication, see mt::external_sort_options.
+ *  @return  Amount of written records.
+ *
+ *  The input is read by chunks of a third of the memory limit, every chunk
+ *  is sorted by mt::sort() and written as a sorted run; reading of the next
+ *  chunk and writing of the previous one are done meanwhile. Then the runs
+ *  are merged by rounds of mt::merge_k() with read-ahead of every run and
+ *  write-behind of the output. With options.unique it is sort-distinct:
+ *  duplicates are dropped by mt::unique() from every run and every round.
+ *  Records have to be trivially copyable, errors of I/O are thrown as
+ *  std::runtime_error.
+ *
+ *  @code
+ *  mt::external_sort_options options;
+ *  options.memory_bytes = 0x100000000;
+ *  mt::external_sort<uint64_t>("keys.bin", "sorted.bin", std::less<uint64_t>(), pool, options);
+ *  @endcode
+*/
+template<typename T, typename Compare>
+CONSTEXPR inline size_t external_sort(const std::string& input, const std::string& output, Compare cmp, mt::thread_pool& pool,
+                                      const external_sort_options& options = external_sort_options())
+{
+    detail::record_file file(input, "rb");
+    const size_t total = file.size_bytes() / sizeof(T);
+    return detail::external_sort<T>([&file](T* to, size_t amount) { return file.read(to, amount); }, total, output, cmp, pool, options);
+}
+
+template<typename T, typename Compare>
+CONSTEXPR inline size_t external_sort(const std::string& input, const std::string& output, Compare cmp)
+{
+    return mt::external_sort<T>(input, output, cmp, mt::default_pool());
+}
+
+template<typename T>
+CONSTEXPR inline size_t external_sort(const std::string& input, const std::string& output, mt::thread_pool& pool)
+{
+    return mt::external_sort<T>(input, output, std::less<T>(), pool);
+}
+
+template<typename T>
+CONSTEXPR inline size_t external_sort(const std::string& input, const std::string& output)
+{
+    return mt::external_sort<T>(input, output, mt::default_pool());
+}
+
+/**
+ *  @brief Sort records of a sequence, e.g. of a memory mapped file, into a file.
+ *  @param  begin    A random access iterator.
+ *  @param  end      A random access iterator.
+ *  @param  output   Path of the sorted file, it is overwritten.
+ *  @param  cmp      A comparison functor.
+ *  @param  pool     Thread pool which will be used for sorting and merging.
+ *  @param  options  See mt::external_sort_options.
+ *  @return  Amount of written records.
+ *
+ *  The same as above, the sequence is not changed.
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline size_t external_sort(RandomAccessIterator begin, RandomAccessIterator end, const std::string& output, Compare cmp,
+                                      mt::thread_pool& pool, const external_sort_options& options = external_sort_options())
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    const size_t total = std::distance(begin, end);
+    size_t offset = 0;
+    return detail::external_sort<value_type>([begin, total, &offset](value_type* to, size_t amount) {
+        amount = std::min(amount, total - offset);
+        std::copy(begin + offset, begin + (offset + amount), to);
+        offset += amount;
+        return amount;
+    }, total, output, cmp, pool, options);
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline size_t external_sort(RandomAccessIterator begin, RandomAccessIterator end, const std::string& output, mt::thread_pool& pool)
+{
+    return mt::external_sort(begin, end, output, std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline size_t external_sort(RandomAccessIterator begin, RandomAccessIterator end, const std::string& output)
+{
+    return mt::external_sort(begin, end, output, mt::default_pool());
+}
+
+}
+
+#endif // MT_EXTERNAL_SORT_HPP
@@ -0,0 +1,359 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/future.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_FUTURE_HPP
+#define MT_FUTURE_HPP
+
+#include "task.hpp"
+#include <atomic>               // for std::atomic
+#include <mutex>                // for std::mutex
+#include <condition_variable>   // for std::condition_variable
+#include <exception>            // for std::exception_ptr
+#include <future>               // for std::future_error
+#include <thread>               // for std::this_thread::yield
+#include <type_traits>          // for std::aligned_storage, std::result_of
+#include <utility>              // for std::move
+
+namespace mt {
+
+namespace detail {
+
+/**
+ *  @brief Shared state of mt::future.
+ *
+ *  Completion is a single atomic exchange. The mutex and the condition
+ *  variable are touched only when somebody has already gone to sleep
+ *  waiting for the result or a continuation has been set by on_ready().
+*/
+template<class R>
+class future_state {
+public:
+    enum { pending, waiting, ready };
+
+    future_state() : refs(2) {}
+    ~future_state() {
+        if (state == ready && !error && !taken) {
+            value_ptr()->~R();
+        }
+    }
+
+    template<class... Args>
+    void set_value(Args&&... args) {
+        new (&value) R(std::forward<Args>(args)...);
+        complete();
+    }
+
+    void set_exception(std::exception_ptr e) {
+        error = e;
+        complete();
+    }
+
+    bool is_ready() const {
+        return state.load(std::memory_order_acquire) == ready;
+    }
+
+    void wait() {
+        // Results of short tasks are usually ready very soon
+        for (size_t i = 0; i < spin_limit && !is_ready(); i++) {
+            std::this_thread::yield();
+        }
+        if (is_ready()) return;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        int expected = pending;
+        state.compare_exchange_strong(expected, waiting);
+        while (!is_ready()) {
+            cv.wait(lock);
+        }
+    }
+
+    // Calls func() when the result is ready, at once if it is ready already. Only one continuation may be set
+    template<class Function>
+    void on_ready(Function&& func) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            int expected = pending;
+            if (state.compare_exchange_strong(expected, waiting) || expected == waiting) {
+                continuation.emplace(std::forward<Function>(func)); // complete() takes the mutex, so it is seen
+                return;
+            }
+        }
+        func();
+    }
+
+    R get() {
+        wait();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        taken = true;
+        R result(std::move(*value_ptr()));
+        value_ptr()->~R();
+        return result;
+    }
+
+    void release() {
+        if (--refs == 0) {
+            delete this;
+        }
+    }
+
+private:
+    static const size_t spin_limit = 64;
+
+    std::atomic<int> state {pending};
+    std::atomic<int> refs;
+    typename std::aligned_storage<sizeof(R), alignof(R)>::type value;
+    std::exception_ptr error;
+    bool taken {false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    mt::task continuation;
+
+    R* value_ptr() {
+        return reinterpret_cast<R*>(&value);
+    }
+
+    void complete() {
+        if (state.exchange(ready, std::memory_order_acq_rel) == waiting) {
+            mt::task next;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+                next = std::move(continuation);
+            }
+            if (next) next();
+        }
+    }
+};
+
+// There is nothing to store for void
+struct future_void {};
+
+template<class R>
+struct future_value {
+    typedef R type;
+};
+
+template<>
+struct future_value<void> {
+    typedef future_void type;
+};
+
+template<class R, class Function>
+struct future_task {
+    future_state<typename future_value<R>::type>* state;
+    Function func;
+
+    future_task(future_state<typename future_value<R>::type>* state, Function&& func) : state(state), func(std::move(func)) {}
+    future_task(future_task&& other) noexcept(std::is_nothrow_move_constructible<Function>::value) : state(other.state), func(std::move(other.func)) {
+        other.state = nullptr;
+    }
+    ~future_task() {
+        if (state) {
+            // The task has never been executed
+            state->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            state->release();
+        }
+    }
+
+    void operator()() {
+        try {
+            run(std::is_void<R>());
+        } catch (...) {
+            state->set_exception(std::current_exception());
+        }
+        state->release();
+        state = nullptr;
+    }
+
+private:
+    void run(std::true_type) {
+        func();
+        state->set_value();
+    }
+    void run(std::false_type) {
+        state->set_value(func());
+    }
+};
+
+template<class R, class Function>
+struct continuation_result {
+    typedef typename std::result_of<Function(R)>::type type;
+};
+
+template<class Function>
+struct continuation_result<void, Function> {
+    typedef typename std::result_of<Function()>::type type;
+};
+
+// Calls the continuation with the result of the previous future, its exception is rethrown to the next one
+template<class R, class U, class Function>
+struct continuation_call {
+    future_state<typename future_value<R>::type>* prev;
+    Function func;
+
+    continuation_call(future_state<typename future_value<R>::type>* prev, Function&& func) : prev(prev), func(std::move(func)) {}
+    continuation_call(continuation_call&& other) noexcept(std::is_nothrow_move_constructible<Function>::value)
+        : prev(other.prev), func(std::move(other.func)) {
+        other.prev = nullptr;
+    }
+    ~continuation_call() {
+        if (prev) prev->release();
+    }
+
+    U operator()() {
+        return call(std::is_void<R>());
+    }
+
+private:
+    U call(std::true_type) {
+        prev->get();
+        return func();
+    }
+    U call(std::false_type) {
+        return func(prev->get());
+    }
+};
+
+// Set by future::then(), pushes the continuation to the pool when the previous future is ready
+template<class R, class U, class Function, class Pool>
+struct continuation_launch {
+    future_state<typename future_value<R>::type>* prev;
+    future_state<typename future_value<U>::type>* next;
+    Function func;
+    Pool* pool;
+
+    void operator()() {
+        pool->push(future_task<U, continuation_call<R, U, Function>>(next, continuation_call<R, U, Function>(prev, std::move(func))));
+    }
+};
+
+}
+
+/**
+ *  @brief Result of a task pushed by mt::thread_pool::submit().
+ *
+ *  Unlike std::future it costs a single allocation and atomic operation
+ *  per task while nobody is blocked waiting for the result. Continuations
+ *  may be chained by then().
+*/
+template<class R>
+class future {
+public:
+    future() noexcept {}
+    future(const future&) = delete;
+    future& operator=(const future&) = delete;
+    future(future&& other) noexcept : state(other.state) {
+        other.state = nullptr;
+    }
+    future& operator=(future&& other) noexcept {
+        std::swap(state, other.state);
+        return *this;
+    }
+    ~future() {
+        if (state) state->release();
+    }
+
+    bool valid() const noexcept {
+        return state != nullptr;
+    }
+
+    bool is_ready() const {
+        return state->is_ready();
+    }
+
+    void wait() const {
+        state->wait();
+    }
+
+    /**
+     *  @brief Wait for the result and take it.
+     *  @return  The value returned by the task.
+     *
+     *  Rethrows an exception thrown by the task. The future becomes invalid
+     *  after this call.
+    */
+    R get() {
+        future moved(std::move(*this));
+        return take(moved.state, std::is_void<R>());
+    }
+
+    /**
+     *  @brief Run a function with the result when it is ready.
+     *  @param  pool  Thread pool, the function is run by its task.
+     *  @param  func  A functor which takes the result, or nothing for future<void>.
+     *  @return  A future of the value returned by @p func.
+     *
+     *  Nobody waits for the result, so pipelines of several steps, e.g. of
+     *  mt::sort_async(), occupy threads of the pool only while they work.
+     *  If the task throws an exception @p func isn't called and the
+     *  exception is rethrown by the returned future. The future becomes
+     *  invalid after this call.
+    */
+    template<class Pool, class Function, class U = typename detail::continuation_result<R, Function>::type>
+    future<U> then(Pool& pool, Function func) {
+        typedef typename future<U>::state_type next_type;
+        state_type* prev = state;
+        state = nullptr;
+        next_type* next = new next_type();
+        prev->on_ready(detail::continuation_launch<R, U, Function, Pool> {prev, next, std::move(func), &pool});
+        return future<U>(next);
+    }
+
+private:
+    typedef detail::future_state<typename detail::future_value<R>::type> state_type;
+
+    friend class thread_pool;
+    template<class> friend class future;
+
+    state_type* state {nullptr};
+
+    explicit future(state_type* state) : state(state) {}
+
+    static R take(state_type* state, std::false_type) {
+        return state->get();
+    }
+    static R take(state_type* state, std::true_type) {
+        state->get();
+    }
+};
+
+}
+
+#endif // MT_FUTURE_HPP
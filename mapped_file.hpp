@@ -0,0 +1,236 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/mapped_file.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_MAPPED_FILE_HPP
+#define MT_MAPPED_FILE_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include <cerrno>       // for errno
+#include <cstring>      // for strerror
+#include <stdexcept>    // for std::runtime_error
+#include <string>       // for std::string
+#include <type_traits>  // for std::is_trivially_copyable
+#include <fcntl.h>      // for open
+#include <sys/mman.h>   // for mmap, madvise
+#include <sys/stat.h>   // for fstat
+#include <unistd.h>     // for ftruncate, sysconf
+
+namespace mt {
+
+enum class map_mode {
+    read_only,  // records can't be changed, e.g. input of mt::external_sort()
+    read_write  // changes of records are written to the file
+};
+
+/**
+ *  @brief File of fixed size records of type @e T mapped to memory.
+ *
+ *  It is a random access range of records, so algorithms of this library
+ *  run on the file in place, without a copy in a std::vector:
+ *  @code
+ *  mt::mapped_file<uint64_t> keys("keys.bin", pool);
+ *  mt::sort(keys.begin(), keys.end(), pool);
+ *  keys.resize(mt::unique(keys.begin(), keys.end(), pool) - keys.begin());
+ *  @endcode
+ *
+ *  Pages are faulted in when it is opened by parts of the algorithms'
+ *  threads, unless it is opened for streaming, so first touches aren't
+ *  serialised and on NUMA systems pages are placed on nodes of workers
+ *  which process them. Transparent huge pages and sequential read-ahead
+ *  are requested, where the kernel has got them. Errors are thrown as
+ *  std::runtime_error.
+*/
+template<typename T>
+class mapped_file {
+public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+
+    static_assert(std::is_trivially_copyable<T>::value, "mt::mapped_file requires trivially copyable records");
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    /**
+     *  @brief Map an existing file.
+     *  @param  path  Path of the file, a trailing part which is smaller than a record is ignored.
+     *  @param  pool  Thread pool which is used for prefaulting.
+     *  @param  mode  Whether records are written to the file.
+     *  @param  prefault  If it is false, pages are read on demand with sequential read-ahead, e.g. for streaming of files bigger than memory.
+    */
+    mapped_file(const std::string& path, mt::thread_pool& pool = mt::default_pool(), map_mode mode = map_mode::read_write,
+                bool prefault = true)
+        : path(path), mode(mode), descriptor(-1), records(nullptr), records_amount(0), mapped_bytes(0) {
+        descriptor = open(path.c_str(), mode == map_mode::read_only ? O_RDONLY : O_RDWR);
+        if (descriptor < 0) fail("can't open");
+        try {
+            struct stat status;
+            if (fstat(descriptor, &status) != 0) fail("can't read");
+            map(static_cast<size_t>(status.st_size) / sizeof(T), pool, prefault);
+        } catch (...) {
+            // the destructor isn't run for a throwing constructor
+            release();
+            throw;
+        }
+    }
+
+    /**
+     *  @brief Create a file of @p size records, an existing one is overwritten.
+     *  @param  path  Path of the file.
+     *  @param  size  Amount of records, they are zero-filled.
+     *  @param  pool  Thread pool which is used for prefaulting.
+    */
+    mapped_file(const std::string& path, size_t size, mt::thread_pool& pool = mt::default_pool())
+        : path(path), mode(map_mode::read_write), descriptor(-1), records(nullptr), records_amount(0), mapped_bytes(0) {
+        descriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (descriptor < 0) fail("can't create");
+        try {
+            if (ftruncate(descriptor, size * sizeof(T)) != 0) fail("can't resize");
+            map(size, pool, true);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    mapped_file(mapped_file&& other) noexcept
+        : path(std::move(other.path)), mode(other.mode), descriptor(other.descriptor), records(other.records),
+          records_amount(other.records_amount), mapped_bytes(other.mapped_bytes) {
+        other.descriptor = -1;
+        other.records = nullptr;
+        other.records_amount = 0;
+        other.mapped_bytes = 0;
+    }
+
+    ~mapped_file() {
+        release();
+    }
+
+    T* begin() { return records; }
+    T* end() { return records + records_amount; }
+    const T* begin() const { return records; }
+    const T* end() const { return records + records_amount; }
+    T* data() { return records; }
+    const T* data() const { return records; }
+    T& operator[](size_t i) { return records[i]; }
+    const T& operator[](size_t i) const { return records[i]; }
+    size_t size() const { return records_amount; }
+    bool empty() const { return records_amount == 0; }
+
+    /**
+     *  @brief Shrink the file to the first @p size records, e.g. to the result of mt::unique().
+     *
+     *  The mapping is kept, so iterators of the remaining records stay valid.
+    */
+    void resize(size_t size) {
+        if (size > records_amount) throw std::runtime_error("mt: mapped file " + path + " can only be shrunk");
+        if (mode == map_mode::read_only) throw std::runtime_error("mt: mapped file " + path + " is read-only");
+        if (ftruncate(descriptor, size * sizeof(T)) != 0) fail("can't resize");
+        records_amount = size;
+    }
+
+    // Writes changed records to the file, otherwise it is done by the kernel later or when it is unmapped
+    void sync() {
+        if (mapped_bytes && msync(records, records_amount * sizeof(T), MS_SYNC) != 0) fail("can't write");
+    }
+
+private:
+    void fail(const char* what) const {
+        throw std::runtime_error(std::string("mt: ") + what + " " + path + ": " + strerror(errno));
+    }
+
+    void release() {
+        if (mapped_bytes) munmap(records, mapped_bytes);
+        if (descriptor >= 0) close(descriptor);
+        records = nullptr;
+        records_amount = 0;
+        mapped_bytes = 0;
+        descriptor = -1;
+    }
+
+    void map(size_t size, mt::thread_pool& pool, bool prefault) {
+        if (size == 0) return;
+        const size_t bytes = size * sizeof(T);
+        const int protection = mode == map_mode::read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+        void* address = mmap(nullptr, bytes, protection, MAP_SHARED, descriptor, 0);
+        if (address == MAP_FAILED) fail("can't map");
+        records = static_cast<T*>(address);
+        records_amount = size;
+        mapped_bytes = bytes;
+#ifdef MADV_HUGEPAGE
+        madvise(address, bytes, MADV_HUGEPAGE);
+#endif
+        madvise(address, bytes, MADV_SEQUENTIAL);
+        if (!prefault) return;
+        populate(pool);
+        // algorithms access their parts in parallel, so early reclaim of sequential mappings isn't wanted
+        madvise(address, bytes, MADV_NORMAL);
+    }
+
+    // Every thread faults in the pages of its part, by one call if the kernel can populate them
+    void populate(mt::thread_pool& pool) {
+        const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        const size_t pages = (mapped_bytes + page_size - 1) / page_size;
+        char* bytes = reinterpret_cast<char*>(records);
+        const bool writable = mode == map_mode::read_write;
+        mt::parallel_for(0, pages, [bytes, page_size, writable, this](size_t from, size_t to) {
+            char* part = bytes + from * page_size;
+            const size_t length = std::min(to * page_size, mapped_bytes) - from * page_size;
+#if defined(MADV_POPULATE_READ) && defined(MADV_POPULATE_WRITE)
+            if (madvise(part, length, writable ? MADV_POPULATE_WRITE : MADV_POPULATE_READ) == 0) return;
+#endif
+            (void)writable;
+            for (size_t offset = 0; offset < length; offset += page_size) {
+                *static_cast<volatile char*>(part + offset);
+            }
+        }, pool, 1);
+    }
+
+    std::string path;
+    map_mode mode;
+    int descriptor;
+    T* records;
+    size_t records_amount;
+    size_t mapped_bytes;
+};
+
+}
+
+#endif // MT_MAPPED_FILE_HPP
@@ -0,0 +1,407 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/merge.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_MERGE_HPP
+#define MT_MERGE_HPP
+
+#include "thread_pool.hpp"
+#include <algorithm>    // for std::merge, std::sort
+#include <functional>   // for std::less
+#include <iterator>     // for std::make_move_iterator
+#include <utility>      // for std::pair
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Parts of output smaller than this are not worth a separate task
+static const size_t merge_min_block_size = 0x4000;
+
+/**
+ *  @brief Split point of a merge (merge path).
+ *  @return  Amount of elements of @p a which are among the first @p k elements
+ *  of the stable merge of @p a and @p b, the others are the first k - result
+ *  elements of @p b.
+ *
+ *  Equal elements of @p a go before ones of @p b, as in std::merge().
+*/
+template<typename It1, typename It2, typename Compare>
+inline size_t co_rank(size_t k, It1 a, size_t a_size, It2 b, size_t b_size, Compare& cmp)
+{
+    size_t low = k > b_size ? k - b_size : 0;
+    size_t high = std::min(k, a_size);
+    while (low < high) {
+        const size_t i = low + (high - low) / 2;
+        const size_t j = k - i;
+        // a[i] goes before b[j - 1], so more elements of a are taken
+        if (j > 0 && !cmp(b[j - 1], a[i])) low = i + 1;
+        else high = i;
+    }
+    return low;
+}
+
+/**
+ *  @brief Write the stable merge of two sorted ranges to @p out by several tasks of @p group.
+ *
+ *  The output is split into @p parts_amount equal parts, every task finds
+ *  the parts of both ranges which form its part of the output by co_rank().
+ *  Tasks are not waited for. Elements are copied, move iterators can be
+ *  passed to move them.
+*/
+template<typename It1, typename It2, typename OutputIt, typename Compare>
+inline void parallel_merge(It1 a, size_t a_size, It2 b, size_t b_size, OutputIt out, Compare& cmp,
+                           mt::task_group& group, size_t parts_amount)
+{
+    const size_t size = a_size + b_size;
+    parts_amount = std::max<size_t>(1, std::min(parts_amount, size / merge_min_block_size));
+    for (size_t part = 0; part < parts_amount; part++) {
+        const size_t from = size * part / parts_amount;
+        const size_t to = size * (part + 1) / parts_amount;
+        group.run([a, a_size, b, b_size, out, &cmp, from, to]{
+            const size_t a_from = detail::co_rank(from, a, a_size, b, b_size, cmp);
+            const size_t a_to = detail::co_rank(to, a, a_size, b, b_size, cmp);
+            std::merge(a + a_from, a + a_to, b + (from - a_from), b + (to - a_to), out + from, cmp);
+        });
+    }
+}
+
+// Serial stable merge of several sorted ranges, ties are taken from the range which goes first.
+// Buffers of @p capacity elements are taken unless the part is bigger, so parts of a call reuse the same blocks.
+template<typename RandomAccessIterator, typename OutputIt, typename Compare>
+inline void merge_k_part(std::vector<std::pair<RandomAccessIterator, RandomAccessIterator>>& ranges, OutputIt out, Compare& cmp,
+                         scratch_arena& arena, size_t capacity)
+{
+    typedef std::pair<RandomAccessIterator, RandomAccessIterator> range_type;
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const range_type& r) { return r.first == r.second; }), ranges.end());
+    if (ranges.empty()) return;
+    if (ranges.size() == 1) {
+        std::copy(ranges[0].first, ranges[0].second, out);
+        return;
+    }
+    if (ranges.size() == 2) {
+        std::merge(ranges[0].first, ranges[0].second, ranges[1].first, ranges[1].second, out, cmp);
+        return;
+    }
+    // pairs of neighbour runs are merged in passes, it is faster than a heap or a loser
+    // tree, because every comparison of a two-way merge depends on less memory loads
+    size_t size = 0;
+    for (const range_type& range: ranges) size += range.second - range.first;
+    scratch_buffer<value_type> first_buffer(arena, size, capacity), second_buffer(arena, size, capacity);
+    value_type* src = first_buffer.begin();
+    value_type* dst = second_buffer.begin();
+    std::vector<size_t> bounds(1, 0);
+    for (size_t i = 0; i < ranges.size(); i += 2) {
+        value_type* to = src + bounds.back();
+        if (i + 1 < ranges.size()) {
+            to = std::merge(ranges[i].first, ranges[i].second, ranges[i + 1].first, ranges[i + 1].second, to, cmp);
+        } else {
+            to = std::copy(ranges[i].first, ranges[i].second, to);
+        }
+        bounds.push_back(to - src);
+    }
+    while (bounds.size() > 3) {
+        std::vector<size_t> merged(1, 0);
+        for (size_t run = 0; run + 1 < bounds.size(); run += 2) {
+            auto from = std::make_move_iterator(src + bounds[run]);
+            auto middle = std::make_move_iterator(src + bounds[run + 1]);
+            auto to = std::make_move_iterator(src + (run + 2 < bounds.size() ? bounds[run + 2] : bounds[run + 1]));
+            merged.push_back(std::merge(from, middle, middle, to, dst + merged.back(), cmp) - dst);
+        }
+        bounds.swap(merged);
+        std::swap(src, dst);
+    }
+    std::merge(std::make_move_iterator(src), std::make_move_iterator(src + bounds[1]),
+               std::make_move_iterator(src + bounds[1]), std::make_move_iterator(src + size), out, cmp);
+}
+
+/**
+ *  @brief Split several sorted ranges into parts of their stable merge.
+ *  @return  bounds[part * ranges.size() + i] is the beginning of the part in the i-th range.
+ *
+ *  Splitters are taken from an evenly spaced sample of all the ranges and
+ *  are ordered as in the merge, so the parts are nearly equal, and every
+ *  part can be merged independently.
+*/
+template<typename RandomAccessIterator, typename Compare>
+inline std::vector<size_t> merge_k_bounds(const std::vector<std::pair<RandomAccessIterator, RandomAccessIterator>>& ranges, size_t size,
+                                          size_t parts_amount, Compare& cmp)
+{
+    const size_t k = ranges.size();
+    std::vector<size_t> bounds((parts_amount + 1) * k, 0);
+    for (size_t i = 0; i < k; i++) {
+        bounds[parts_amount * k + i] = ranges[i].second - ranges[i].first;
+    }
+    if (parts_amount < 2) return bounds;
+
+    const size_t samples_amount = parts_amount * 16;
+    std::vector<std::pair<size_t, size_t>> samples; // range and position
+    for (size_t i = 0; i < k; i++) {
+        const size_t length = ranges[i].second - ranges[i].first;
+        const size_t amount = (length * samples_amount + size - 1) / size;
+        for (size_t s = 0; s < amount; s++) {
+            samples.push_back(std::make_pair(i, length * (2 * s + 1) / (2 * amount)));
+        }
+    }
+    std::sort(samples.begin(), samples.end(), [&ranges, &cmp](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+        const auto& x = ranges[a.first].first[a.second];
+        const auto& y = ranges[b.first].first[b.second];
+        if (cmp(x, y)) return true;
+        if (cmp(y, x)) return false;
+        return a < b;
+    });
+    for (size_t part = 1; part < parts_amount; part++) {
+        const std::pair<size_t, size_t>& splitter = samples[samples.size() * part / parts_amount];
+        const auto& value = ranges[splitter.first].first[splitter.second];
+        for (size_t i = 0; i < k; i++) {
+            size_t bound = splitter.second;
+            // equal elements of previous ranges go before the splitter, ones of next ranges go after it
+            if (i < splitter.first) bound = std::upper_bound(ranges[i].first, ranges[i].second, value, cmp) - ranges[i].first;
+            else if (i > splitter.first) bound = std::lower_bound(ranges[i].first, ranges[i].second, value, cmp) - ranges[i].first;
+            bounds[part * k + i] = bound;
+        }
+    }
+    return bounds;
+}
+
+// Moves the sequence to the buffer and merges it back
+template<typename RandomAccessIterator, typename Compare, typename BufferIt>
+inline void inplace_merge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, Compare& cmp,
+                          mt::thread_pool& pool, BufferIt buffer)
+{
+    const size_t size = std::distance(first, last), size1 = std::distance(first, middle);
+    if (size1 == 0 || size1 == size) return;
+    mt::task_group group(pool);
+    // merge with an empty range is a parallel move
+    detail::parallel_merge(std::make_move_iterator(first), size, std::make_move_iterator(first), 0, buffer, cmp, group, pool.size());
+    group.wait();
+    detail::parallel_merge(std::make_move_iterator(buffer), size1, std::make_move_iterator(buffer + size1), size - size1,
+                           first, cmp, group, pool.size());
+    group.wait();
+}
+
+}
+
+/**
+ *  @brief Merge two sorted sequences.
+ *  @param  first1  A random access iterator of the first sequence.
+ *  @param  last1   A random access iterator.
+ *  @param  first2  A random access iterator of the second sequence.
+ *  @param  last2   A random access iterator.
+ *  @param  d_first A random access iterator, the beginning of the destination.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as std::merge(), the merge is stable. The output is split into
+ *  equal parts, the parts of both sequences which form a part of the output
+ *  are found by binary search, so every thread merges its part independently.
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt merge(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                OutputIt d_first, Compare cmp, mt::thread_pool& pool)
+{
+    const size_t size1 = std::distance(first1, last1), size2 = std::distance(first2, last2);
+    mt::task_group group(pool);
+    detail::parallel_merge(first1, size1, first2, size2, d_first, cmp, group, pool.size());
+    group.wait();
+    return d_first + (size1 + size2);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt merge(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                OutputIt d_first, Compare cmp)
+{
+    return mt::merge(first1, last1, first2, last2, d_first, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt merge(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                OutputIt d_first, mt::thread_pool& pool)
+{
+    return mt::merge(first1, last1, first2, last2, d_first, std::less<typename std::iterator_traits<RandomAccessIterator1>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt merge(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                OutputIt d_first)
+{
+    return mt::merge(first1, last1, first2, last2, d_first, mt::default_pool());
+}
+
+/**
+ *  @brief Merge several sorted sequences.
+ *  @param  ranges_begin  An input iterator of std::pair of random access iterators, the sequences to be merged.
+ *  @param  ranges_end    An input iterator.
+ *  @param  d_first       A random access iterator, the beginning of the destination.
+ *  @param  cmp           A comparison functor.
+ *  @param  pool          Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The merge is stable, equal elements are taken in the order of the
+ *  sequences. The output is split into nearly equal parts by splitters
+ *  sampled from all the sequences, so all the sequences are read once, and
+ *  every thread merges its part independently.
+ *
+ *  @code
+ *  std::vector<std::pair<int*, int*>> shards = {{a, a + a_size}, {b, b + b_size}, {c, c + c_size}};
+ *  mt::merge_k(shards.begin(), shards.end(), result.begin(), pool);
+ *  @endcode
+*/
+template<typename RangeIt, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt merge_k(RangeIt ranges_begin, RangeIt ranges_end, OutputIt d_first, Compare cmp, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RangeIt>::value_type::first_type iterator;
+    const std::vector<std::pair<iterator, iterator>> ranges(ranges_begin, ranges_end);
+    size_t size = 0;
+    for (const auto& range: ranges) size += std::distance(range.first, range.second);
+    if (size == 0) return d_first;
+
+    const size_t parts_amount = std::max<size_t>(1, std::min(pool.size() * 4, size / detail::merge_min_block_size));
+    const std::vector<size_t> bounds = detail::merge_k_bounds(ranges, size, parts_amount, cmp);
+    const size_t k = ranges.size();
+    scratch_arena& arena = pool.scratch();
+    const size_t capacity = 2 * size / parts_amount;
+
+    mt::task_group group(pool);
+    for (size_t part = 0; part < parts_amount; part++) {
+        group.run([&ranges, &bounds, &cmp, &arena, d_first, part, k, capacity]{
+            std::vector<std::pair<iterator, iterator>> parts(k);
+            size_t offset = 0;
+            for (size_t i = 0; i < k; i++) {
+                parts[i] = std::make_pair(ranges[i].first + bounds[part * k + i], ranges[i].first + bounds[(part + 1) * k + i]);
+                offset += bounds[part * k + i];
+            }
+            detail::merge_k_part(parts, d_first + offset, cmp, arena, capacity);
+        });
+    }
+    group.wait();
+    return d_first + size;
+}
+
+template<typename RangeIt, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt merge_k(RangeIt ranges_begin, RangeIt ranges_end, OutputIt d_first, Compare cmp)
+{
+    return mt::merge_k(ranges_begin, ranges_end, d_first, cmp, mt::default_pool());
+}
+
+template<typename RangeIt, typename OutputIt>
+CONSTEXPR inline OutputIt merge_k(RangeIt ranges_begin, RangeIt ranges_end, OutputIt d_first, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RangeIt>::value_type::first_type iterator;
+    return mt::merge_k(ranges_begin, ranges_end, d_first, std::less<typename std::iterator_traits<iterator>::value_type>(), pool);
+}
+
+template<typename RangeIt, typename OutputIt>
+CONSTEXPR inline OutputIt merge_k(RangeIt ranges_begin, RangeIt ranges_end, OutputIt d_first)
+{
+    return mt::merge_k(ranges_begin, ranges_end, d_first, mt::default_pool());
+}
+
+/**
+ *  @brief Merge two consecutive sorted sequences in place.
+ *  @param  first   A random access iterator, the beginning of the first sequence.
+ *  @param  middle  A random access iterator, the beginning of the second sequence.
+ *  @param  last    A random access iterator.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for processing.
+ *  @param  buffer  Scratch memory, it is resized to the size of the sequence if it is smaller.
+ *  @return  Nothing.
+ *
+ *  The same as std::inplace_merge(). The sequence is moved to @p buffer and
+ *  merged back in parallel, so repeated calls with the same @p buffer don't
+ *  allocate memory. Contents of @p buffer are unspecified after the call.
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void inplace_merge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, Compare cmp,
+                                    mt::thread_pool& pool, std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type>& buffer)
+{
+    const size_t size = std::distance(first, last);
+    if (buffer.size() < size) buffer.resize(size);
+    detail::inplace_merge(first, middle, last, cmp, pool, buffer.begin());
+}
+
+/**
+ *  @brief Merge two consecutive sorted sequences in place.
+ *  @param  first   A random access iterator, the beginning of the first sequence.
+ *  @param  middle  A random access iterator, the beginning of the second sequence.
+ *  @param  last    A random access iterator.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for processing.
+ *  @return  Nothing.
+ *
+ *  The same as above, but the buffer is taken from pool.scratch().
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void inplace_merge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, Compare cmp,
+                                    mt::thread_pool& pool)
+{
+    scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type> buffer(pool.scratch(), std::distance(first, last));
+    detail::inplace_merge(first, middle, last, cmp, pool, buffer.begin());
+}
+
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void inplace_merge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, Compare cmp)
+{
+    mt::inplace_merge(first, middle, last, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline void inplace_merge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last, mt::thread_pool& pool)
+{
+    mt::inplace_merge(first, middle, last, std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline void inplace_merge(RandomAccessIterator first, RandomAccessIterator middle, RandomAccessIterator last)
+{
+    mt::inplace_merge(first, middle, last, mt::default_pool());
+}
+
+}
+
+#endif // MT_MERGE_HPP
@@ -0,0 +1,289 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Benchmarks of mt algorithms against the standard ones, see `make bench`.
+//
+//   ./mt_bench [--sizes 1e3,1e6] [--threads 1,8] [--dists uniform,zipf] [--keys u32,u64,record]
+//              [--algos mt::sort,std::sort] [--reps 7] [--format csv|json] [--max-bytes 8e9]
+//
+// Every case is run --reps times on a fresh copy of the same data; timings exclude data
+// generation and copying. Results are written to stdout, progress and skipped cases to stderr.
+
+#include "thread_pool.hpp"
+#include "sort.hpp"
+#include "stable_sort.hpp"
+#include "parallel_for.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+// MT_BENCH_NO_PAR leaves out std::sort(par), libstdc++'s <execution> needs TBB libraries if its headers are installed
+#if defined(__has_include) && !defined(MT_BENCH_NO_PAR)
+#if __has_include(<execution>) && __cplusplus >= 201703L
+#include <execution>
+#endif
+#if __has_include(<tbb/global_control.h>)
+#include <tbb/global_control.h>
+#define MT_BENCH_TBB_CONTROL
+#endif
+#endif
+#if defined(__cpp_lib_parallel_algorithm) && !defined(MT_BENCH_NO_PAR)
+#define MT_BENCH_PAR
+#endif
+
+namespace {
+
+struct record {
+    uint64_t key;
+    char payload[24];
+
+    bool operator<(const record& other) const { return key < other.key; }
+    bool operator==(const record& other) const { return key == other.key; }
+};
+
+// Counter-based generator: element i is a function of (seed, i), so parts of the data are generated in parallel
+inline uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline double unit(uint64_t x)
+{
+    return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+template<typename T> T make_key(uint64_t value);
+template<> uint32_t make_key<uint32_t>(uint64_t value) { return static_cast<uint32_t>(value); }
+template<> uint64_t make_key<uint64_t>(uint64_t value) { return value; }
+template<> record make_key<record>(uint64_t value)
+{
+    record r;
+    r.key = value;
+    memset(r.payload, static_cast<int>(value), sizeof(r.payload));
+    return r;
+}
+
+// Values of every distribution are 64-bit, keys of narrower types take their low bits
+template<typename T>
+void generate(std::vector<T>& data, const std::string& dist, uint64_t seed, mt::thread_pool& pool)
+{
+    const size_t size = data.size();
+    // Zipf with s = 1 over up to 2^20 ranks by an inverse CDF table, ranks are spread over the keys by hashing
+    std::vector<double> cdf;
+    if (dist == "zipf") {
+        cdf.resize(std::min<size_t>(size, 1 << 20));
+        double sum = 0;
+        for (size_t i = 0; i < cdf.size(); i++) cdf[i] = sum += 1.0 / (i + 1);
+        for (double& c: cdf) c /= sum;
+    }
+    mt::parallel_for(0, size, [&](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) {
+            const uint64_t random = splitmix64(seed ^ splitmix64(i));
+            uint64_t value;
+            if (dist == "uniform") value = random;
+            else if (dist == "zipf") value = splitmix64(std::lower_bound(cdf.begin(), cdf.end(), unit(random)) - cdf.begin());
+            else if (dist == "sorted") value = i;
+            else if (dist == "reverse") value = size - i;
+            else if (dist == "organ-pipe") value = i < size / 2 ? i : size - i;
+            else value = splitmix64(random % 16); // few-unique
+            data[i] = make_key<T>(value);
+        }
+    }, pool);
+}
+
+struct result {
+    std::string algorithm, key, distribution;
+    size_t size, threads, reps;
+    double median, p95, bytes;
+};
+
+std::vector<std::string> split(const std::string& list)
+{
+    std::vector<std::string> items;
+    size_t from = 0;
+    while (from <= list.size()) {
+        const size_t to = std::min(list.find(',', from), list.size());
+        if (to > from) items.push_back(list.substr(from, to - from));
+        from = to + 1;
+    }
+    return items;
+}
+
+std::vector<size_t> split_numbers(const std::string& list)
+{
+    std::vector<size_t> numbers;
+    for (const std::string& item: split(list)) numbers.push_back(static_cast<size_t>(strtod(item.c_str(), nullptr)));
+    return numbers;
+}
+
+template<typename T>
+bool run_algorithm(const std::string& algorithm, std::vector<T>& data, mt::thread_pool& pool, size_t threads)
+{
+    (void)threads;
+    if (algorithm == "mt::sort") {
+        mt::sort(data.begin(), data.end(), pool);
+    } else if (algorithm == "mt::stable_sort") {
+        mt::stable_sort(data.begin(), data.end(), std::less<T>(), pool);
+    } else if (algorithm == "std::sort") {
+        std::sort(data.begin(), data.end());
+#ifdef MT_BENCH_PAR
+    } else if (algorithm == "std::sort(par)") {
+        std::sort(std::execution::par, data.begin(), data.end());
+#endif
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+void bench_key(const std::string& key, const std::vector<size_t>& sizes, const std::vector<size_t>& threads_list,
+               const std::vector<std::string>& dists, const std::vector<std::string>& algorithms, size_t reps, double max_bytes,
+               std::vector<result>& results)
+{
+    for (size_t threads: threads_list) {
+        mt::thread_pool pool(threads);
+#ifdef MT_BENCH_TBB_CONTROL
+        tbb::global_control control(tbb::global_control::max_allowed_parallelism, threads);
+#endif
+        for (size_t size: sizes) {
+            if (2.0 * size * sizeof(T) > max_bytes) {
+                fprintf(stderr, "skip %s size %zu: %.1fGB is more than --max-bytes\n", key.c_str(), size, 2.0 * size * sizeof(T) / 1e9);
+                continue;
+            }
+            for (const std::string& dist: dists) {
+                std::vector<T> source(size);
+                generate(source, dist, 0x5EED ^ size, pool);
+                std::vector<T> data(size);
+                for (const std::string& algorithm: algorithms) {
+                    std::vector<double> times;
+                    bool known = true;
+                    for (size_t rep = 0; rep < reps && known; rep++) {
+                        mt::parallel_for(0, size, [&](size_t from, size_t to) {
+                            std::copy(source.begin() + from, source.begin() + to, data.begin() + from);
+                        }, pool);
+                        const auto start = std::chrono::steady_clock::now();
+                        known = run_algorithm(algorithm, data, pool, threads);
+                        const auto end = std::chrono::steady_clock::now();
+                        times.push_back(std::chrono::duration<double>(end - start).count());
+                        if (known && !std::is_sorted(data.begin(), data.end())) {
+                            fprintf(stderr, "error: %s didn't sort %s %s of size %zu\n", algorithm.c_str(), key.c_str(), dist.c_str(), size);
+                            exit(1);
+                        }
+                    }
+                    if (!known) {
+                        fprintf(stderr, "skip unknown or unavailable algorithm %s\n", algorithm.c_str());
+                        continue;
+                    }
+                    std::sort(times.begin(), times.end());
+                    const double median = times.size() % 2 ? times[times.size() / 2] : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+                    const double p95 = times[std::min(times.size() - 1, static_cast<size_t>(std::ceil(0.95 * times.size())) - 1)];
+                    results.push_back(result {algorithm, key, dist, size, threads, reps, median, p95, double(size * sizeof(T))});
+                    fprintf(stderr, "%-16s %-6s %-10s %12zu x%-3zu median %.6fsec\n", algorithm.c_str(), key.c_str(), dist.c_str(), size, threads, median);
+                }
+            }
+        }
+    }
+}
+
+void print(const std::vector<result>& results, const std::string& format)
+{
+    const bool json = format == "json";
+    printf(json ? "[\n" : "algorithm,key,distribution,size,threads,reps,median_sec,p95_sec,elements_per_sec,gb_per_sec\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+        const double elements_per_sec = r.median > 0 ? r.size / r.median : 0;
+        const double gb_per_sec = r.median > 0 ? r.bytes / r.median / 1e9 : 0;
+        if (json) {
+            printf("  {\"algorithm\": \"%s\", \"key\": \"%s\", \"distribution\": \"%s\", \"size\": %zu, \"threads\": %zu, \"reps\": %zu, "
+                   "\"median_sec\": %.9f, \"p95_sec\": %.9f, \"elements_per_sec\": %.1f, \"gb_per_sec\": %.4f}%s\n",
+                   r.algorithm.c_str(), r.key.c_str(), r.distribution.c_str(), r.size, r.threads, r.reps, r.median, r.p95,
+                   elements_per_sec, gb_per_sec, i + 1 < results.size() ? "," : "");
+        } else {
+            printf("%s,%s,%s,%zu,%zu,%zu,%.9f,%.9f,%.1f,%.4f\n", r.algorithm.c_str(), r.key.c_str(), r.distribution.c_str(),
+                   r.size, r.threads, r.reps, r.median, r.p95, elements_per_sec, gb_per_sec);
+        }
+    }
+    if (json) printf("]\n");
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string sizes = "1e3,1e4,1e5,1e6,1e7,1e8,1e9";
+    std::string threads = std::to_string(std::thread::hardware_concurrency());
+    std::string dists = "uniform,zipf,sorted,reverse,organ-pipe,few-unique";
+    std::string keys = "u32,u64,record";
+    std::string algorithms = "mt::sort,mt::stable_sort,std::sort,std::sort(par)";
+    std::string format = "csv";
+    size_t reps = 7;
+    double max_bytes = 0.8 * sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i], value = argv[i + 1];
+        if (option == "--sizes") sizes = value;
+        else if (option == "--threads") threads = value;
+        else if (option == "--dists") dists = value;
+        else if (option == "--keys") keys = value;
+        else if (option == "--algos") algorithms = value;
+        else if (option == "--reps") reps = std::max<size_t>(1, strtoul(value.c_str(), nullptr, 10));
+        else if (option == "--format") format = value;
+        else if (option == "--max-bytes") max_bytes = strtod(value.c_str(), nullptr);
+        else {
+            fprintf(stderr, "unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+
+    for (const std::string& dist: split(dists)) {
+        if (dist != "uniform" && dist != "zipf" && dist != "sorted" && dist != "reverse" && dist != "organ-pipe" && dist != "few-unique") {
+            fprintf(stderr, "unknown distribution %s\n", dist.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<result> results;
+    for (const std::string& key: split(keys)) {
+        if (key == "u32") bench_key<uint32_t>(key, split_numbers(sizes), split_numbers(threads), split(dists), split(algorithms), reps, max_bytes, results);
+        else if (key == "u64") bench_key<uint64_t>(key, split_numbers(sizes), split_numbers(threads), split(dists), split(algorithms), reps, max_bytes, results);
+        else if (key == "record") bench_key<record>(key, split_numbers(sizes), split_numbers(threads), split(dists), split(algorithms), reps, max_bytes, results);
+        else fprintf(stderr, "skip unknown key %s\n", key.c_str());
+    }
+    print(results, format);
+    return 0;
+}
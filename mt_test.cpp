@@ -25,11 +25,45 @@
  * SOFTWARE.
  */
 
+#include "task.hpp"
 #include "thread_pool.hpp"
+#include "scratch_arena.hpp"
 #include "sort.hpp"
 #include "unique.hpp"
+#include "partition.hpp"
+#include "radix_sort.hpp"
+#include "stable_sort.hpp"
+#include "sort_by_key.hpp"
+#include "merge.hpp"
+#include "nth_element.hpp"
+#include "algorithm.hpp"
+#include "parallel_for.hpp"
+#include "numeric.hpp"
+#include "search.hpp"
+#include "external_sort.hpp"
+#include "mapped_file.hpp"
+#include "distinct.hpp"
+#include "set_operations.hpp"
+#include "async.hpp"
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+#include <numeric>
+#include <stdexcept>
+#include <limits>
+#include <string>
+#include <sstream>
+#include <unordered_set>
+
+// splitmix64 of a counter, full range values without the int overflow of rand() * rand()
+static uint32_t random_value()
+{
+    static uint64_t counter = 0;
+    uint64_t z = counter += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return uint32_t(z ^ (z >> 31));
+}
 
 static std::atomic<size_t> f_without_arg_call_count;
 static void f_without_arg()
@@ -49,7 +83,6 @@ static void f_with_args(size_t arg0, size_t arg1)
     f_with_args_call_count++;
 }
 
-#ifdef MT_POOL_RET_SUPPORT
 static std::atomic<size_t> f_with_ret_call_count;
 static std::atomic<size_t> f_with_ret_arg0;
 static std::atomic<size_t> f_with_ret_arg1;
@@ -61,7 +94,11 @@ static size_t f_with_ret(size_t arg0, size_t arg1)
     f_with_ret_call_count++;
     return arg0 + arg1;
 }
-#endif
+
+static void f_with_exception()
+{
+    throw std::runtime_error("f_with_exception");
+}
 
 static void test_one_call_without_arg()
 {
@@ -131,6 +168,154 @@ static void test_a_few_calls_with_args()
     assert(f_with_args_call_count == 4);
 }
 
+static void test_one_call_with_submit()
+{
+    // Given:
+    mt::thread_pool tpool;
+    f_with_ret_call_count = 0;
+    f_with_ret_arg0 = 0;
+    f_with_ret_arg1 = 0;
+
+    // When:
+    auto future = tpool.submit(f_with_ret, 123, 456);
+    auto ret = future.get();
+
+    // Then:
+    assert(!future.valid());
+    assert(f_with_ret_call_count == 1);
+    assert(f_with_ret_arg0 == 123);
+    assert(f_with_ret_arg1 == 456);
+    assert(ret == 123 + 456);
+}
+
+static void test_a_few_calls_with_submit()
+{
+    // Given:
+    mt::thread_pool tpool(4);
+    std::vector<size_t> data(0x100000);
+    for (size_t i = 0; i < data.size(); i++) { data[i] = i; }
+
+    // When:
+    std::vector<mt::future<size_t>> futures;
+    for (size_t i = 0; i < 16; i++) {
+        auto part_begin = data.begin() + data.size() / 16 * i;
+        auto part_end = part_begin + data.size() / 16;
+        futures.push_back(tpool.submit([part_begin, part_end]{ return std::accumulate(part_begin, part_end, size_t(0)); }));
+    }
+    auto done = tpool.submit([]{});
+    size_t sum = 0;
+    for (auto& future: futures) { sum += future.get(); }
+    done.get();
+
+    // Then:
+    assert(sum == data.size() * (data.size() - 1) / 2);
+}
+
+static void test_submit_with_exception()
+{
+    // Given:
+    mt::thread_pool tpool;
+    bool caught = false;
+
+    // When:
+    auto future = tpool.submit(f_with_exception);
+    try {
+        future.get();
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+
+    // Then:
+    assert(caught);
+}
+
+static void spawn_nested(mt::task_group& group, std::atomic<size_t>& counter, size_t depth)
+{
+    counter++;
+    if (depth == 0) return;
+    group.run(spawn_nested, std::ref(group), std::ref(counter), depth - 1);
+    group.run(spawn_nested, std::ref(group), std::ref(counter), depth - 1);
+}
+
+static void test_task_group_nested()
+{
+    // Given:
+    mt::thread_pool tpool(4);
+    mt::task_group group(tpool);
+    std::atomic<size_t> counter {0};
+
+    // When:
+    group.run(spawn_nested, std::ref(group), std::ref(counter), 10);
+    group.wait();
+
+    // Then:
+    assert(counter == (1u << 11) - 1);
+}
+
+static void test_task_groups_sharing_pool()
+{
+    // Given:
+    mt::thread_pool tpool(2);
+    mt::task_group blocked_group(tpool);
+    mt::task_group group(tpool);
+    std::atomic<bool> started {false};
+    std::atomic<bool> release {false};
+    std::atomic<size_t> counter {0};
+
+    // When:
+    blocked_group.run([&started, &release]{ started = true; while (!release) std::this_thread::yield(); });
+    while (!started) std::this_thread::yield(); // otherwise the waiting thread could take it itself
+    for (size_t i = 0; i < 100; i++) {
+        group.run([&counter]{ counter++; });
+    }
+    group.wait();
+
+    // Then:
+    assert(counter == 100); // the group is complete while another one is still running
+    release = true;
+    blocked_group.wait();
+}
+
+static void test_task_group_wait_inside_task()
+{
+    // Given:
+    mt::thread_pool tpool(1); // the only worker has to run inner tasks itself
+    std::atomic<size_t> counter {0};
+
+    // When:
+    auto future = tpool.submit([&tpool, &counter]{
+        mt::task_group inner(tpool);
+        for (size_t i = 0; i < 10; i++) {
+            inner.run([&counter]{ counter++; });
+        }
+        inner.wait();
+        return counter.load();
+    });
+
+    // Then:
+    assert(future.get() == 10);
+}
+
+static void test_task_group_with_exception()
+{
+    // Given:
+    mt::thread_pool tpool;
+    mt::task_group group(tpool);
+    bool caught = false;
+
+    // When:
+    group.run(f_with_exception);
+    group.run(f_without_arg);
+    try {
+        group.wait();
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+
+    // Then:
+    assert(caught);
+}
+
 #ifdef MT_POOL_RET_SUPPORT
 static void test_one_call_with_ret()
 {
@@ -174,6 +359,190 @@ static void test_a_few_calls_with_ret()
 }
 #endif
 
+static void test_pool_affinity()
+{
+    // Given:
+    const std::vector<unsigned> cpus = mt::detail::parse_cpu_list("0-3,8,10-11\n");
+    const mt::cpu_topology& topology = mt::system_topology();
+
+    // When:
+    mt::thread_pool tpool(6, mt::affinity::cores);
+    std::vector<uint32_t> data(0x1000000);
+    mt::parallel_for(0, data.size(), [&data](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) data[i] = uint32_t(rand());
+    }, tpool);
+    std::vector<uint32_t> expected = data;
+    std::sort(expected.begin(), expected.end());
+    mt::sort(data.begin(), data.end(), tpool);
+    std::atomic<size_t> done {0};
+    {
+        mt::task_group group(tpool);
+        for (size_t i = 0; i < 100; i++) {
+            group.run_at(i % tpool.size(), [&done]{ done++; });
+        }
+        group.wait();
+    }
+
+    // Then:
+    assert((cpus == std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}));
+    assert(mt::detail::parse_cpu_list("").empty() && mt::detail::parse_cpu_list("5") == std::vector<unsigned>{5});
+    assert(!topology.nodes.empty() && !topology.nodes[0].empty());
+    assert(tpool.nodes_amount() == topology.nodes.size());
+    for (size_t i = 1; i < tpool.size(); i++) {
+        assert(tpool.node_of(i - 1) <= tpool.node_of(i) && tpool.node_of(i) < tpool.nodes_amount());
+    }
+    assert(mt::thread_pool(2).nodes_amount() == 1);
+    assert(mt::detail::home_worker(tpool, 0, 600) == 0 && mt::detail::home_worker(tpool, 599, 600) == 5);
+    assert(mt::detail::home_worker(tpool, 100, 600) == 1 && mt::detail::home_worker(tpool, 0, 0) == 0);
+    assert(data == expected);
+    assert(done == 100);
+}
+
+template<size_t ROUNDS = 0x400>
+static void test_pool_wake_latency()
+{
+    const size_t threads_amount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    const mt::idle_policy policies[] = {mt::idle_policy(), mt::idle_policy(std::chrono::microseconds(0), 0)};
+    double latencies[2];
+
+    for (size_t policy = 0; policy < 2; policy++) {
+        // Given:
+        mt::thread_pool tpool(threads_amount, mt::affinity::none, policies[policy]);
+        std::atomic<size_t> done {0};
+        std::chrono::duration<double, std::micro> total(0);
+
+        // When:
+        for (size_t round = 0; round < ROUNDS; round++) {
+            // a short pause between bursts of work, as between levels of mt::sort
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            auto start = std::chrono::high_resolution_clock::now();
+            tpool.push([&done]{ done++; });
+            while (done != round + 1) { std::this_thread::yield(); }
+            total += std::chrono::high_resolution_clock::now() - start;
+        }
+
+        // Then:
+        assert(done == ROUNDS);
+        assert(tpool.idle_amount() <= tpool.size());
+        latencies[policy] = total.count() / ROUNDS;
+    }
+    fprintf(stderr, "%s: spin then park: %0.1fus, park at once: %0.1fus\n", __PRETTY_FUNCTION__, latencies[0], latencies[1]);
+
+    // an explicit policy survives construction even of an oversubscribed pool, the automatic one doesn't spin there
+    const mt::idle_policy spinning(std::chrono::microseconds(20), 4);
+    mt::thread_pool oversubscribed(std::thread::hardware_concurrency() + 1, mt::affinity::none, spinning);
+    assert(oversubscribed.get_idle_policy().spin == spinning.spin && oversubscribed.get_idle_policy().yields == spinning.yields);
+    mt::thread_pool automatic(std::thread::hardware_concurrency() + 1);
+    assert(automatic.get_idle_policy().spin.count() == 0 && automatic.get_idle_policy().yields == 0);
+}
+
+template<size_t SIZE = 0x100000>
+static void test_pool_overhead()
+{
+    mt::thread_pool tpool;
+    std::atomic<size_t> counter {0};
+
+    // When:
+    auto external_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < SIZE; i++) {
+        tpool.push([&counter]{ counter++; });
+    }
+    tpool.wait();
+    auto external_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::nano> external_time = external_end - external_start;
+
+    auto nested_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < tpool.size(); i++) {
+        // Every worker spawns its own share of tasks, as mt::sort does
+        tpool.push([&tpool, &counter, i]{
+            const size_t amount = SIZE / tpool.size() + (i < SIZE % tpool.size() ? 1 : 0);
+            for (size_t j = 0; j < amount; j++) {
+                tpool.push([&counter]{ counter++; });
+            }
+        });
+    }
+    tpool.wait();
+    auto nested_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::nano> nested_time = nested_end - nested_start;
+
+    // Then:
+    assert(counter == 2 * SIZE);
+    fprintf(stderr, "%s: external: %0.1fns/task, nested: %0.1fns/task\n", __PRETTY_FUNCTION__, external_time.count() / SIZE, nested_time.count() / SIZE);
+}
+
+template<size_t SIZE = 0x100000>
+static void test_pool_task_throughput()
+{
+    // Callable which doesn't fit into small buffer of std::function (48 bytes of arguments)
+    std::atomic<size_t> counter {0};
+    auto func = [&counter](size_t a, size_t b, size_t c, size_t d, size_t e) { counter += (a + b + c + d + e) > 0; };
+
+    // When:
+    auto function_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < SIZE; i++) {
+        std::function<void()> task(std::bind(func, i, 1, 2, 3, 4));
+        task();
+    }
+    auto function_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> function_time = function_end - function_start;
+
+    auto task_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < SIZE; i++) {
+        mt::task task(std::bind(func, i, 1, 2, 3, 4));
+        task();
+    }
+    auto task_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> task_time = task_end - task_start;
+
+    mt::thread_pool tpool;
+    auto pool_start = std::chrono::high_resolution_clock::now();
+    tpool.push([&tpool, &func]{
+        for (size_t i = 0; i < SIZE; i++) {
+            tpool.push(func, i, 1, 2, 3, 4);
+        }
+    });
+    tpool.wait();
+    auto pool_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> pool_time = pool_end - pool_start;
+
+    // Then:
+    assert(counter == 3 * SIZE);
+    fprintf(stderr, "%s: std::function: %0.1fM tasks/sec, mt::task: %0.1fM tasks/sec, pool: %0.1fM tasks/sec\n", __PRETTY_FUNCTION__,
+            SIZE / function_time.count() / 1e6, SIZE / task_time.count() / 1e6, SIZE / pool_time.count() / 1e6);
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_partition()
+{
+    std::vector<uint32_t> actual(SIZE);
+    std::vector<uint32_t> expected(SIZE);
+    auto pred = [](uint32_t d) { return d % 3 == 0; };
+
+    // Given:
+    for (auto& d: actual) { d = random_value(); }
+    expected = actual;
+    auto stl_start = std::chrono::high_resolution_clock::now();
+    auto stl_middle = std::partition(expected.begin(), expected.end(), pred);
+    auto stl_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+    // When:
+    mt::thread_pool tpool(std::max(4u, std::thread::hardware_concurrency()));
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    auto mt_middle = mt::partition(actual.begin(), actual.end(), pred, tpool);
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    assert(std::distance(actual.begin(), mt_middle) == std::distance(expected.begin(), stl_middle));
+    assert(std::all_of(actual.begin(), mt_middle, pred));
+    assert(std::none_of(mt_middle, actual.end(), pred));
+    std::sort(actual.begin(), actual.end());
+    std::sort(expected.begin(), expected.end());
+    assert(actual == expected);
+    fprintf(stderr, "%s: stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__, stl_time.count(), mt_time.count());
+}
+
 template<size_t SIZE = 0x10000000>
 static void test_sort_rand()
 {
@@ -202,6 +571,83 @@ static void test_sort_rand()
     // "void test_sort_rand() [with long unsigned int SIZE = 268435456]: stl: 19.898sec, mt: 2.487sec"
 }
 
+template<typename T, size_t SIZE = 0x10000000>
+static void test_radix_sort_rand()
+{
+    std::vector<T> data(SIZE);
+    for (auto& d: data) { d = T(rand()) * T(rand()) * T(rand()); }
+
+    // Given:
+    std::vector<T> stl = data;
+    std::vector<T> mt = data;
+    std::vector<T> radix = data;
+
+    // When:
+    auto stl_start = std::chrono::high_resolution_clock::now();
+    std::sort(stl.begin(), stl.end());
+    auto stl_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    mt::sort(mt.begin(), mt.end());
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    auto radix_start = std::chrono::high_resolution_clock::now();
+    mt::radix_sort(radix.begin(), radix.end());
+    auto radix_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> radix_time = radix_end - radix_start;
+
+    // Then:
+    assert(mt == stl);
+    assert(radix == stl);
+    fprintf(stderr, "%s: stl: %0.3fsec, mt: %0.3fsec, radix: %0.3fsec\n", __PRETTY_FUNCTION__, stl_time.count(), mt_time.count(), radix_time.count());
+}
+
+template<typename T>
+static void check_radix_sort(std::vector<T> actual)
+{
+    std::vector<T> expected = actual;
+    std::vector<T> reversed = actual;
+    std::sort(expected.begin(), expected.end());
+    mt::radix_sort(actual.begin(), actual.end());
+    assert(actual == expected);
+
+    std::sort(expected.begin(), expected.end(), std::greater<T>());
+    mt::sort(mt::sort_policy::radix_sort(), reversed.begin(), reversed.end(), std::greater<T>());
+    assert(reversed == expected);
+}
+
+template<size_t SIZE = 0x100000>
+static void test_radix_sort_signed_and_float()
+{
+    std::vector<int32_t> ints(SIZE);
+    std::vector<int64_t> longs(SIZE);
+    std::vector<float> floats(SIZE);
+    std::vector<double> doubles(SIZE);
+    std::vector<uint8_t> bytes(SIZE);
+
+    // Given:
+    for (size_t i = 0; i < SIZE; i++) {
+        ints[i] = rand() - RAND_MAX / 2;
+        longs[i] = int64_t(rand() - RAND_MAX / 2) * rand();
+        floats[i] = float(rand() - RAND_MAX / 2) / 1000;
+        doubles[i] = double(rand() - RAND_MAX / 2) * rand() / 3;
+        bytes[i] = rand();
+    }
+    floats[0] = -std::numeric_limits<float>::infinity();
+    doubles[0] = std::numeric_limits<double>::max();
+
+    // When + Then:
+    check_radix_sort(ints);
+    check_radix_sort(longs);
+    check_radix_sort(floats);
+    check_radix_sort(doubles);
+    check_radix_sort(bytes);
+    check_radix_sort(std::vector<uint32_t>(SIZE, 42)); // every pass is skipped
+    static_assert(!mt::detail::is_radix_sortable<long double>::value, "long double doesn't fit a radix key");
+}
+
 template<size_t SIZE = 0x10000000>
 static void test_sort_sorted()
 {
@@ -231,6 +677,69 @@ static void test_sort_sorted()
     // "void test_sort_sorted() [with long unsigned int SIZE = 268435456]: stl: 3.547sec, mt: 0.582sec"
 }
 
+template<size_t SIZE = 0x10000000>
+static void test_sort_presorted()
+{
+    mt::thread_pool tpool(4);
+    mt::sort_tuning no_runs;
+    no_runs.detect_runs = false;
+
+    const char* names[] = {"sorted", "reversed", "reversed with ties", "8 sorted runs", "sorted with unsorted tail", "sorted with swaps",
+                           "organ pipe", "sawtooth", "alternating runs", "random"};
+    for (size_t pattern = 0; pattern < sizeof(names) / sizeof(names[0]); pattern++) {
+        // Given:
+        std::vector<uint32_t> actual(SIZE);
+        for (auto& d: actual) { d = random_value(); }
+        switch (pattern) {
+        case 0: std::sort(actual.begin(), actual.end()); break;
+        case 1: std::sort(actual.begin(), actual.end(), std::greater<uint32_t>()); break;
+        case 2: for (auto& d: actual) { d %= 1000; } std::sort(actual.begin(), actual.end(), std::greater<uint32_t>()); break;
+        case 3: for (size_t run = 0; run < 8; run++) { std::sort(actual.begin() + SIZE * run / 8, actual.begin() + SIZE * (run + 1) / 8); } break;
+        case 4: std::sort(actual.begin(), actual.end() - SIZE / 16); break;
+        case 5: std::sort(actual.begin(), actual.end()); for (size_t i = 0; i < 1000; i++) { std::swap(actual[rand() % SIZE], actual[rand() % SIZE]); } break;
+        case 6: std::sort(actual.begin(), actual.begin() + SIZE / 2); std::sort(actual.begin() + SIZE / 2, actual.end(), std::greater<uint32_t>()); break;
+        case 7: for (size_t i = 0; i < SIZE; i++) { actual[i] = uint32_t(i % (SIZE / 16)); } break;
+        case 8:
+            for (size_t run = 0; run < 8; run++) {
+                if (run % 2) std::sort(actual.begin() + SIZE * run / 8, actual.begin() + SIZE * (run + 1) / 8, std::greater<uint32_t>());
+                else std::sort(actual.begin() + SIZE * run / 8, actual.begin() + SIZE * (run + 1) / 8);
+            }
+            break;
+        default: break;
+        }
+        std::vector<uint32_t> expected = actual;
+        std::sort(expected.begin(), expected.end());
+        std::vector<uint32_t> without_runs = actual;
+
+        // When:
+        auto mt_start = std::chrono::high_resolution_clock::now();
+        mt::sort(actual.begin(), actual.end(), tpool);
+        auto mt_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+        auto no_runs_start = std::chrono::high_resolution_clock::now();
+        mt::sort(mt::sort_policy::quick_sort(no_runs), without_runs.begin(), without_runs.end(), tpool);
+        auto no_runs_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> no_runs_time = no_runs_end - no_runs_start;
+
+        // Then:
+        assert(actual == expected);
+        assert(without_runs == expected);
+        fprintf(stderr, "%s: %s: mt: %0.3fsec, without detection of runs: %0.3fsec\n", __PRETTY_FUNCTION__, names[pattern],
+                mt_time.count(), no_runs_time.count());
+    }
+
+    // the order of runs of equal elements doesn't matter, but all of them are kept
+    std::vector<std::pair<int, int>> pairs(0x100000);
+    for (size_t i = 0; i < pairs.size(); i++) { pairs[i] = std::make_pair(int(i % 7 == 0 ? pairs.size() - i : i), int(i % 3)); }
+    std::vector<std::pair<int, int>> pairs_expected = pairs;
+    auto by_first = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; };
+    mt::sort(pairs.begin(), pairs.end(), by_first, tpool);
+    std::sort(pairs_expected.begin(), pairs_expected.end());
+    std::sort(pairs.begin(), pairs.end());
+    assert(pairs == pairs_expected);
+}
+
 template<size_t SIZE = 0x10000000>
 static void test_sort_a_lot_of_duplicates()
 {
@@ -259,6 +768,145 @@ static void test_sort_a_lot_of_duplicates()
     // "void test_sort_a_lot_of_duplicates() [with long unsigned int SIZE = 268435456]: stl: 7.917sec, mt: 2.369sec"
 }
 
+template<size_t SIZE = 0x10000000>
+static void test_sort_duplicate_ratios()
+{
+    // distinct values in the data, 0 means that 90% of values are one of 4 hot keys, others are random
+    for (uint32_t distinct: {2u, 16u, 256u, 65536u, 0u}) {
+        // Given:
+        std::vector<uint32_t> actual(SIZE);
+        for (auto& d: actual) {
+            if (distinct) d = rand() % distinct;
+            else d = rand() % 10 ? rand() % 4 : random_value();
+        }
+        std::vector<uint32_t> expected = actual;
+        auto stl_start = std::chrono::high_resolution_clock::now();
+        std::sort(expected.begin(), expected.end());
+        auto stl_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+        // When:
+        auto mt_start = std::chrono::high_resolution_clock::now();
+        mt::sort(actual.begin(), actual.end());
+        auto mt_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+        // Then:
+        assert(actual == expected);
+        fprintf(stderr, "%s: distinct: %u, stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__,
+                distinct, stl_time.count(), mt_time.count());
+    }
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_sort_sample_sort()
+{
+    std::vector<uint32_t> rand_data(SIZE);
+    std::vector<uint32_t> duplicates_data(SIZE);
+    for (auto& d: rand_data) { d = random_value(); }
+    for (auto& d: duplicates_data) { d = rand() % UINT8_MAX; }
+
+    for (auto data: {&rand_data, &duplicates_data}) {
+        // Given:
+        std::vector<uint32_t> quick = *data;
+        std::vector<uint32_t> sample = *data;
+        std::vector<uint32_t> expected = *data;
+        std::sort(expected.begin(), expected.end());
+
+        // When:
+        auto quick_start = std::chrono::high_resolution_clock::now();
+        mt::sort(mt::sort_policy::quick_sort(), quick.begin(), quick.end());
+        auto quick_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> quick_time = quick_end - quick_start;
+
+        auto sample_start = std::chrono::high_resolution_clock::now();
+        mt::sort(mt::sort_policy::sample_sort(), sample.begin(), sample.end());
+        auto sample_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> sample_time = sample_end - sample_start;
+
+        // Then:
+        assert(quick == expected);
+        assert(sample == expected);
+        fprintf(stderr, "%s: %s: quick_sort: %0.3fsec, sample_sort: %0.3fsec\n", __PRETTY_FUNCTION__,
+                data == &rand_data ? "rand" : "a lot of duplicates", quick_time.count(), sample_time.count());
+    }
+}
+
+template<size_t SIZE = 0x100000, size_t BATCHES = 16>
+static void test_sort_shared_pool()
+{
+    std::vector<std::vector<uint32_t>> actual(BATCHES, std::vector<uint32_t>(SIZE));
+    std::vector<std::vector<uint32_t>> expected(BATCHES);
+    mt::thread_pool tpool(4);
+
+    // Given:
+    for (auto& batch: actual) {
+        for (auto& d: batch) { d = random_value(); }
+    }
+    auto backup = actual;
+    for (size_t i = 0; i < BATCHES; i++) {
+        expected[i] = actual[i];
+        std::sort(expected[i].begin(), expected[i].end());
+    }
+
+    // When:
+    auto own_start = std::chrono::high_resolution_clock::now();
+    for (auto& batch: actual) {
+        mt::sort(batch.begin(), batch.end(), std::less<uint32_t>(), tpool.size());
+    }
+    auto own_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> own_time = own_end - own_start;
+    assert(actual == expected);
+
+    actual = backup;
+    auto shared_start = std::chrono::high_resolution_clock::now();
+    for (auto& batch: actual) {
+        mt::sort(batch.begin(), batch.end(), tpool);
+    }
+    auto shared_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> shared_time = shared_end - shared_start;
+
+    // Then:
+    assert(actual == expected);
+    fprintf(stderr, "%s: own pool: %0.3fsec, shared pool: %0.3fsec\n", __PRETTY_FUNCTION__, own_time.count(), shared_time.count());
+}
+
+template<size_t ROUNDS = 0x40>
+static void test_sort_tuning()
+{
+    mt::thread_pool tpool(4);
+    mt::sort_tuning fine;
+    fine.min_leaf_bytes = 0;
+    fine.tasks_per_thread = 0x1000;
+    mt::sort_tuning eager_only;
+    eager_only.split_while_idle = false;
+
+    for (size_t size: {0x10, 0x100, 0x1000, 0x10000}) {
+        // Given:
+        std::vector<uint32_t> data(size);
+        for (auto& d: data) { d = random_value(); }
+        std::vector<uint32_t> expected = data;
+        std::sort(expected.begin(), expected.end());
+
+        // When:
+        std::chrono::duration<double> times[3];
+        const mt::sort_tuning* tunings[3] = {&fine, &eager_only, nullptr};
+        for (size_t i = 0; i < 3; i++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t round = 0; round < ROUNDS; round++) {
+                std::vector<uint32_t> actual = data;
+                mt::sort(tunings[i] ? mt::sort_policy::quick_sort(*tunings[i]) : mt::sort_policy::quick_sort(),
+                         actual.begin(), actual.end(), tpool);
+                // Then:
+                assert(actual == expected);
+            }
+            times[i] = std::chrono::high_resolution_clock::now() - start;
+        }
+        fprintf(stderr, "%s: size: %zu, fine: %0.3fsec, eager only: %0.3fsec, default: %0.3fsec\n",
+                __PRETTY_FUNCTION__, size, times[0].count(), times[1].count(), times[2].count());
+    }
+}
+
 template<size_t SIZE = 0x100000000>
 static void test_unique()
 {
@@ -323,6 +971,1115 @@ static void test_unique_a_lot_of_duplicates()
     // "void test_unique_a_lot_of_duplicates() [with long unsigned int SIZE = 4294967296]: stl: 2.116sec, mt: 0.378sec"
 }
 
+template<size_t SIZE = 0x100000, size_t BATCHES = 16>
+static void test_unique_shared_pool()
+{
+    mt::thread_pool tpool(4);
+
+    for (size_t i = 0; i < BATCHES; i++) {
+        // Given:
+        std::vector<uint32_t> actual(SIZE >> i);
+        for (auto& d: actual) { d = rand() % UINT8_MAX; }
+        std::sort(actual.begin(), actual.end());
+        auto expected = actual;
+        expected.resize(std::distance(expected.begin(), std::unique(expected.begin(), expected.end())));
+
+        // When:
+        auto mt_last = mt::unique(actual.begin(), actual.end(), tpool);
+        actual.resize(std::distance(actual.begin(), mt_last));
+
+        // Then:
+        assert(actual == expected);
+    }
+}
+
+template<size_t SIZE = 0x200>
+static void test_unique_compaction()
+{
+    mt::thread_pool tpool(4);
+
+    for (size_t size = 0; size < SIZE; size++) {
+        for (int distinct: {1, 2, 8, 1000}) {
+            // Given: unsorted data, so runs of equal values cross parts in different ways
+            std::vector<std::string> actual(size);
+            for (auto& d: actual) { d = std::to_string(rand() % distinct) + std::string(16, 'x'); }
+            auto expected = actual;
+            expected.resize(std::distance(expected.begin(), std::unique(expected.begin(), expected.end())));
+
+            // When:
+            auto mt_last = mt::unique(actual.begin(), actual.end(), tpool);
+            actual.resize(std::distance(actual.begin(), mt_last));
+
+            // Then:
+            assert(actual == expected);
+        }
+    }
+
+    // values which can't be default constructed
+    struct no_default {
+        explicit no_default(int value) : value(value) {}
+        bool operator==(const no_default& other) const { return value == other.value; }
+        bool operator<(const no_default& other) const { return value < other.value; }
+        int value;
+    };
+    std::vector<no_default> actual;
+    for (size_t i = 0; i < 0x10000; i++) { actual.push_back(no_default(rand() % 8)); }
+    auto sorted = actual, distinct = actual;
+    auto expected = actual;
+    expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+    actual.erase(mt::unique(actual.begin(), actual.end(), tpool), actual.end());
+    assert(actual == expected);
+
+    auto sorted_expected = sorted;
+    std::sort(sorted_expected.begin(), sorted_expected.end());
+    sorted_expected.erase(std::unique(sorted_expected.begin(), sorted_expected.end()), sorted_expected.end());
+    sorted.erase(mt::sort_unique(sorted.begin(), sorted.end(), tpool), sorted.end());
+    assert(sorted == sorted_expected);
+
+    std::vector<no_default> distinct_expected;
+    for (const auto& d: distinct) {
+        if (std::find(distinct_expected.begin(), distinct_expected.end(), d) == distinct_expected.end()) distinct_expected.push_back(d);
+    }
+    auto hash = [](const no_default& d) { return std::hash<int>()(d.value); };
+    distinct.erase(mt::distinct(distinct.begin(), distinct.end(), hash, std::equal_to<no_default>(), tpool), distinct.end());
+    assert(distinct == distinct_expected);
+}
+
+template<typename T>
+static void check_unique_kernel(T* (*kernel)(T*, T*))
+{
+    for (size_t size = 1; size < 0x200; size++) {
+        for (uint32_t distinct: {1u, 2u, 3u, 1000u}) {
+            // Given:
+            std::vector<T> actual(size);
+            for (auto& d: actual) { d = rand() % distinct; }
+            if (distinct != 3) std::sort(actual.begin(), actual.end());
+            auto expected = actual;
+            expected.resize(std::distance(expected.begin(), std::unique(expected.begin(), expected.end())));
+
+            // When:
+            T* last = kernel(actual.data(), actual.data() + size);
+            actual.resize(last - actual.data());
+
+            // Then:
+            assert(actual == expected);
+        }
+    }
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_unique_simd()
+{
+    // Kernels which the CPU supports:
+    check_unique_kernel<uint32_t>(mt::detail::simd_unique<uint32_t>);
+    check_unique_kernel<uint64_t>(mt::detail::simd_unique<uint64_t>);
+    check_unique_kernel<long long>(mt::detail::simd_unique<long long>);
+#ifdef MT_SIMD_UNIQUE
+    if (__builtin_cpu_supports("avx2")) {
+        check_unique_kernel<uint32_t>(mt::detail::unique_avx2);
+        check_unique_kernel<uint64_t>(mt::detail::unique_avx2);
+        check_unique_kernel<unsigned long long>(mt::detail::unique_avx2);
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        check_unique_kernel<uint32_t>(mt::detail::unique_avx512);
+        check_unique_kernel<uint64_t>(mt::detail::unique_avx512);
+        check_unique_kernel<unsigned long long>(mt::detail::unique_avx512);
+    }
+#endif
+    // every integer type of 32 or 64 bits is vectorized, not just the fixed width ones
+    static_assert(mt::detail::is_simd_unique_supported<std::vector<long long>::iterator, std::equal_to<long long>>::value, "");
+    static_assert(mt::detail::is_simd_unique_supported<unsigned long long*, std::equal_to<unsigned long long>>::value, "");
+    static_assert(!mt::detail::is_simd_unique_supported<double*, std::equal_to<double>>::value, "");
+
+    // Given:
+    std::vector<int64_t> actual(SIZE);
+    for (auto& d: actual) { d = int64_t(rand() % 0x1000) - 0x800; }
+    mt::sort(actual.begin(), actual.end());
+    auto expected = actual;
+    auto stl_start = std::chrono::high_resolution_clock::now();
+    expected.resize(std::distance(expected.begin(), std::unique(expected.begin(), expected.end())));
+    auto stl_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+    // When:
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    actual.resize(std::distance(actual.begin(), mt::unique(actual.begin(), actual.end())));
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    assert(actual == expected);
+    fprintf(stderr, "%s: stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__, stl_time.count(), mt_time.count());
+}
+
+template<size_t SIZE = 0x200>
+static void test_unique_copy()
+{
+    mt::thread_pool tpool(4);
+
+    for (size_t size = 0; size < SIZE; size++) {
+        for (int distinct: {1, 2, 8, 1000}) {
+            // Given:
+            std::vector<std::string> data(size);
+            for (auto& d: data) { d = std::to_string(rand() % distinct); }
+            std::vector<std::string> expected(size);
+            expected.resize(std::distance(expected.begin(), std::unique_copy(data.begin(), data.end(), expected.begin())));
+            const auto backup = data;
+
+            // When:
+            std::vector<std::string> actual(size);
+            actual.resize(std::distance(actual.begin(), mt::unique_copy(data.begin(), data.end(), actual.begin(), tpool)));
+
+            // Then:
+            assert(actual == expected);
+            assert(data == backup);
+        }
+    }
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_sort_unique()
+{
+    for (uint32_t distinct: {0x100u, 0x1000000u, 0u}) {
+        // Given:
+        std::vector<uint32_t> data(SIZE);
+        for (auto& d: data) { d = distinct ? rand() % distinct : random_value(); }
+        auto separate = data;
+
+        // When:
+        auto separate_start = std::chrono::high_resolution_clock::now();
+        mt::sort(separate.begin(), separate.end());
+        separate.resize(std::distance(separate.begin(), mt::unique(separate.begin(), separate.end())));
+        auto separate_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> separate_time = separate_end - separate_start;
+
+        auto fused_start = std::chrono::high_resolution_clock::now();
+        data.resize(std::distance(data.begin(), mt::sort_unique(data.begin(), data.end())));
+        auto fused_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> fused_time = fused_end - fused_start;
+
+        // Then:
+        assert(data == separate);
+        fprintf(stderr, "%s: distinct: %u, sort + unique: %0.3fsec, sort_unique: %0.3fsec\n", __PRETTY_FUNCTION__,
+                distinct, separate_time.count(), fused_time.count());
+    }
+
+    // small sequences with a custom comparison
+    mt::thread_pool tpool(4);
+    for (size_t size = 0; size < 0x400; size += 7) {
+        std::vector<std::string> actual(size);
+        for (auto& d: actual) { d = std::to_string(rand() % 64); }
+        auto expected = actual;
+        std::sort(expected.begin(), expected.end(), std::greater<std::string>());
+        expected.resize(std::distance(expected.begin(), std::unique(expected.begin(), expected.end())));
+
+        actual.resize(std::distance(actual.begin(), mt::sort_unique(actual.begin(), actual.end(), std::greater<std::string>(), tpool)));
+        assert(actual == expected);
+    }
+}
+
+static std::vector<uint32_t> read_records(const std::string& path)
+{
+    std::vector<uint32_t> result;
+    FILE* file = fopen(path.c_str(), "rb");
+    assert(file);
+    uint32_t block[0x1000];
+    for (size_t n; (n = fread(block, sizeof(uint32_t), 0x1000, file)) != 0;) result.insert(result.end(), block, block + n);
+    fclose(file);
+    return result;
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_external_sort()
+{
+    mt::thread_pool tpool(4);
+    const std::string input = "mt_test_external_input.bin";
+    const std::string output = "mt_test_external_output.bin";
+
+    // Given:
+    std::vector<uint32_t> expected(SIZE);
+    for (size_t i = 0; i < SIZE; i++) { expected[i] = uint32_t(rand()) * rand(); }
+    FILE* file = fopen(input.c_str(), "wb");
+    assert(file && fwrite(expected.data(), sizeof(uint32_t), SIZE, file) == SIZE);
+    fclose(file);
+    mt::external_sort_options options;
+    options.memory_bytes = SIZE;
+
+    // When:
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    const size_t written = mt::external_sort<uint32_t>(input, output, std::less<uint32_t>(), tpool, options);
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    auto sort_start = std::chrono::high_resolution_clock::now();
+    mt::sort(expected.begin(), expected.end(), tpool);
+    auto sort_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sort_time = sort_end - sort_start;
+
+    // Then:
+    assert(written == SIZE);
+    assert(read_records(output) == expected);
+    fprintf(stderr, "%s: external_sort: %0.3fsec, sort in memory: %0.3fsec\n", __PRETTY_FUNCTION__, mt_time.count(), sort_time.count());
+
+    // runs merged in several passes, deduplication and a sequence as input
+    std::vector<uint32_t> values(0x100000);
+    for (auto& v: values) { v = rand() % 0x10000; }
+    options.memory_bytes = 0x100000;
+    options.unique = true;
+    std::vector<uint32_t> distinct = values;
+    std::sort(distinct.begin(), distinct.end(), std::greater<uint32_t>());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    assert(mt::external_sort(values.begin(), values.end(), output, std::greater<uint32_t>(), tpool, options) == distinct.size());
+    assert(read_records(output) == distinct);
+
+    options.unique = false;
+    std::vector<uint32_t> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    assert(mt::external_sort(values.begin(), values.end(), output, std::less<uint32_t>(), tpool, options) == values.size());
+    assert(read_records(output) == sorted);
+
+    // the whole input in one chunk and an empty one
+    assert(mt::external_sort(values.begin(), values.begin() + 0x100, output, tpool) == 0x100);
+    std::vector<uint32_t> head(values.begin(), values.begin() + 0x100);
+    std::sort(head.begin(), head.end());
+    assert(read_records(output) == head);
+    assert(mt::external_sort(values.begin(), values.begin(), output, tpool) == 0);
+    assert(read_records(output).empty());
+
+    std::remove(input.c_str());
+    std::remove(output.c_str());
+}
+
+template<size_t SIZE = 0x4000000>
+static void test_mapped_file()
+{
+    mt::thread_pool tpool(4);
+    const std::string path = "mt_test_mapped.bin";
+
+    // Given:
+    {
+        mt::mapped_file<uint32_t> file(path, SIZE, tpool);
+        for (size_t i = 0; i < SIZE; i++) { file[i] = uint32_t(rand()) % (SIZE / 2); }
+    }
+
+    // When:
+    auto vector_start = std::chrono::high_resolution_clock::now();
+    std::vector<uint32_t> expected(SIZE);
+    FILE* input = fopen(path.c_str(), "rb");
+    assert(input && fread(expected.data(), sizeof(uint32_t), SIZE, input) == SIZE);
+    fclose(input);
+    mt::sort(expected.begin(), expected.end(), tpool);
+    expected.erase(mt::unique(expected.begin(), expected.end(), tpool), expected.end());
+    FILE* output = fopen((path + ".sorted").c_str(), "wb");
+    assert(output && fwrite(expected.data(), sizeof(uint32_t), expected.size(), output) == expected.size());
+    fclose(output);
+    auto vector_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> vector_time = vector_end - vector_start;
+
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    {
+        mt::mapped_file<uint32_t> file(path, tpool);
+        mt::sort(file.begin(), file.end(), tpool);
+        file.resize(mt::unique(file.begin(), file.end(), tpool) - file.begin());
+    }
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    {
+        const mt::mapped_file<uint32_t> file(path, tpool, mt::map_mode::read_only, false);
+        assert(file.size() == expected.size() && std::equal(file.begin(), file.end(), expected.begin()));
+    }
+    fprintf(stderr, "%s: mapped file: %0.3fsec, vector: %0.3fsec\n", __PRETTY_FUNCTION__, mt_time.count(), vector_time.count());
+
+    // an empty file
+    {
+        mt::mapped_file<uint32_t> file(path, 0, tpool);
+        assert(file.empty() && file.begin() == file.end());
+        mt::sort(file.begin(), file.end(), tpool);
+    }
+
+    // a moved-from file is empty
+    {
+        mt::mapped_file<uint32_t> file(path, 0x1000, tpool);
+        mt::mapped_file<uint32_t> moved(std::move(file));
+        assert(moved.size() == 0x1000 && moved.begin() != nullptr);
+        assert(file.size() == 0 && file.empty() && file.begin() == file.end());
+    }
+
+    // a directory can't be mapped and its descriptor isn't leaked
+    {
+        const int first_free = dup(0);
+        close(first_free);
+        for (int i = 0; i < 100; i++) {
+            try {
+                mt::mapped_file<uint32_t> file(".", tpool, mt::map_mode::read_only);
+            } catch (const std::runtime_error&) {}
+        }
+        const int next_free = dup(0);
+        close(next_free);
+        assert(next_free == first_free);
+    }
+    std::remove(path.c_str());
+    std::remove((path + ".sorted").c_str());
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_scratch_arena()
+{
+    // Given:
+    mt::scratch_arena arena(0x1000000);
+    void* big = arena.acquire(0x800000);
+    void* small = arena.acquire(100);
+    assert(big && small && reinterpret_cast<uintptr_t>(small) % 64 == 0);
+    arena.release(big);
+    arena.release(small);
+    assert(arena.acquire(0x400000) == big && arena.allocations() == 2);
+    arena.release(big);
+    {
+        mt::scratch_buffer<std::string> strings(arena, 0x1000);
+        assert(strings.size() == 0x1000 && strings[0x0fff].empty());
+    }
+    void* over = arena.acquire(0x2000000); // bigger than the cap, it is freed when it is released
+    arena.release(over);
+    assert(arena.size_bytes() <= arena.cap_bytes());
+    arena.shrink();
+    assert(arena.size_bytes() == 0);
+
+    mt::thread_pool tpool(4);
+    std::vector<uint32_t> values(SIZE);
+    std::vector<uint32_t> sorted(SIZE);
+    std::vector<std::pair<const uint32_t*, const uint32_t*>> shards;
+    for (size_t i = 0; i < 8; i++) shards.push_back(std::make_pair(values.data() + SIZE / 8 * i, values.data() + SIZE / 8 * (i + 1)));
+    auto round = [&] {
+        for (auto& v: values) { v = rand(); }
+        mt::sort(mt::sort_policy::radix_sort(), values.begin(), values.end(), tpool);
+        for (auto& v: values) { v = rand(); }
+        mt::stable_sort(values.begin(), values.end(), std::less<uint32_t>(), tpool);
+        for (auto& v: values) { v = rand(); }
+        mt::sort(mt::sort_policy::sample_sort(), values.begin(), values.end(), tpool);
+        mt::sort_by_key(values.begin(), values.end(), [](uint32_t v) { return v % 1000; }, tpool);
+        for (size_t i = 0; i < 8; i++) std::sort(values.begin() + SIZE / 8 * i, values.begin() + SIZE / 8 * (i + 1));
+        mt::merge_k(shards.begin(), shards.end(), sorted.begin(), tpool);
+        assert(std::is_sorted(sorted.begin(), sorted.end()));
+    };
+
+    // When:
+    round();
+    const size_t allocations = tpool.scratch().allocations();
+    round();
+    round();
+
+    mt::thread_pool fresh(4);
+    for (auto& v: values) { v = rand(); }
+    auto first_start = std::chrono::high_resolution_clock::now();
+    mt::sort(mt::sort_policy::radix_sort(), values.begin(), values.end(), fresh);
+    auto first_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> first_time = first_end - first_start;
+
+    for (auto& v: values) { v = rand(); }
+    auto next_start = std::chrono::high_resolution_clock::now();
+    mt::sort(mt::sort_policy::radix_sort(), values.begin(), values.end(), fresh);
+    auto next_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> next_time = next_end - next_start;
+
+    // Then:
+    assert(tpool.scratch().allocations() == allocations);
+    assert(fresh.scratch().allocations() == 1 && std::is_sorted(values.begin(), values.end()));
+    fprintf(stderr, "%s: first radix sort: %0.3fsec, next one: %0.3fsec\n", __PRETTY_FUNCTION__, first_time.count(), next_time.count());
+
+    // an arena shared by pools
+    mt::thread_pool other(2);
+    other.use_scratch(tpool.scratch());
+    mt::stable_sort(values.begin(), values.end(), std::less<uint32_t>(), other);
+    assert(tpool.scratch().allocations() == allocations && std::is_sorted(values.begin(), values.end()));
+    tpool.scratch().shrink();
+    assert(tpool.scratch().size_bytes() == 0);
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_pool_stats()
+{
+#ifdef MT_POOL_STATS
+    mt::thread_pool tpool(4);
+
+    // Given:
+    std::vector<uint32_t> values(SIZE);
+    for (auto& v: values) { v = rand() % 100; }
+    tpool.reset_stats();
+    tpool.start_trace();
+
+    // When:
+    mt::sort(values.begin(), values.end(), tpool);
+    tpool.wait();
+    tpool.stop_trace();
+    const mt::pool_stats stats = tpool.stats();
+
+    // Then:
+    const mt::worker_stats total = stats.total();
+    size_t latencies = 0;
+    for (size_t bucket: total.latency) latencies += bucket;
+    assert(std::is_sorted(values.begin(), values.end()));
+    assert(stats.workers.size() == tpool.size() && total.tasks > 0 && latencies == total.tasks && total.busy.count() > 0);
+    const std::vector<mt::trace_event> trace = tpool.trace();
+    assert(trace.size() == total.tasks);
+    for (const mt::trace_event& e: trace) { assert(e.thread <= tpool.size() && e.duration.count() >= 0); }
+    std::ostringstream json;
+    tpool.write_trace(json);
+    assert(json.str().find("\"traceEvents\"") != std::string::npos && json.str().find("\"ph\":\"X\"") != std::string::npos);
+    for (size_t i = 0; i < stats.workers.size(); i++) {
+        const mt::worker_stats& w = stats.workers[i];
+        fprintf(stderr, "%s: worker %zu: tasks: %zu, steals: %zu, max queue: %zu, busy: %0.3fsec, idle: %0.3fsec, parked: %0.3fsec\n",
+                __PRETTY_FUNCTION__, i, w.tasks, w.steals, w.max_queue_depth, w.busy.count() / 1e9, w.idle.count() / 1e9, w.parked.count() / 1e9);
+    }
+
+    tpool.reset_stats();
+    assert(tpool.stats().total().tasks == 0);
+#endif
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_distinct()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    std::vector<uint32_t> values(SIZE);
+    for (auto& v: values) { v = rand() % (SIZE / 4); }
+    std::vector<uint32_t> expected;
+    {
+        std::unordered_set<uint32_t> seen;
+        for (uint32_t v: values) {
+            if (seen.insert(v).second) expected.push_back(v);
+        }
+    }
+    std::vector<uint32_t> sorted = values;
+
+    // When:
+    auto start = std::chrono::high_resolution_clock::now();
+    values.erase(mt::distinct(values.begin(), values.end(), tpool), values.end());
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time = end - start;
+
+    auto sort_start = std::chrono::high_resolution_clock::now();
+    mt::sort(sorted.begin(), sorted.end(), tpool);
+    sorted.erase(mt::unique(sorted.begin(), sorted.end(), tpool), sorted.end());
+    auto sort_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sort_time = sort_end - sort_start;
+
+    // Then:
+    assert(values == expected && values.size() == sorted.size());
+    fprintf(stderr, "%s: distinct: %0.3fsec, sort and unique: %0.3fsec\n", __PRETTY_FUNCTION__, time.count(), sort_time.count());
+
+    // strings with a case insensitive hash and predicate
+    std::vector<std::string> words = {"One", "two", "ONE", "Three", "TWO", "one", "four"};
+    auto lower = [](std::string s) { for (char& c: s) c = tolower(c); return s; };
+    auto hash = [lower](const std::string& s) { return std::hash<std::string>()(lower(s)); };
+    auto equal = [lower](const std::string& a, const std::string& b) { return lower(a) == lower(b); };
+    words.erase(mt::distinct(words.begin(), words.end(), hash, equal, tpool), words.end());
+    assert((words == std::vector<std::string> {"One", "two", "Three", "four"}));
+
+    std::vector<uint32_t> empty;
+    assert(mt::distinct(empty.begin(), empty.end(), tpool) == empty.end());
+    std::vector<uint32_t> same(SIZE / 16, 7);
+    assert(mt::distinct(same.begin(), same.end()) == same.begin() + 1 && same[0] == 7);
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_set_operations()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    std::vector<uint32_t> a(SIZE), b(SIZE / 2);
+    for (auto& v: a) { v = rand() % SIZE; }
+    for (auto& v: b) { v = rand() % SIZE; }
+    mt::sort(a.begin(), a.end(), tpool);
+    mt::sort(b.begin(), b.end(), tpool);
+    std::vector<uint32_t> expected(a.size() + b.size()), result(a.size() + b.size());
+
+    // When:
+    auto stl_start = std::chrono::high_resolution_clock::now();
+    expected.resize(std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), expected.begin()) - expected.begin());
+    auto stl_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    result.resize(mt::set_intersection(a.begin(), a.end(), b.begin(), b.end(), result.begin(), tpool) - result.begin());
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    assert(result == expected);
+    fprintf(stderr, "%s: set_intersection: stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__, stl_time.count(), mt_time.count());
+
+    expected.resize(a.size() + b.size());
+    result.resize(a.size() + b.size());
+    expected.resize(std::set_union(a.begin(), a.end(), b.begin(), b.end(), expected.begin()) - expected.begin());
+    result.resize(mt::set_union(a.begin(), a.end(), b.begin(), b.end(), result.begin(), tpool) - result.begin());
+    assert(result == expected);
+    expected.resize(std::set_difference(a.begin(), a.end(), b.begin(), b.end(), expected.begin()) - expected.begin());
+    result.resize(mt::set_difference(a.begin(), a.end(), b.begin(), b.end(), result.begin(), tpool) - result.begin());
+    assert(result == expected);
+    result.resize(mt::set_difference(b.begin(), b.end(), a.begin(), a.end(), result.begin(), std::less<uint32_t>()) - result.begin());
+    assert(result.size() <= b.size());
+
+    // duplicates of the same value go to the same part
+    std::vector<uint32_t> ones(SIZE / 4, 1), fewer_ones(SIZE / 8, 1), multiset(SIZE / 4);
+    multiset.resize(mt::set_intersection(ones.begin(), ones.end(), fewer_ones.begin(), fewer_ones.end(), multiset.begin(), tpool) - multiset.begin());
+    assert(multiset.size() == fewer_ones.size());
+    multiset.resize(SIZE / 4);
+    multiset.resize(mt::set_difference(ones.begin(), ones.end(), fewer_ones.begin(), fewer_ones.end(), multiset.begin(), tpool) - multiset.begin());
+    assert(multiset.size() == ones.size() - fewer_ones.size());
+    std::vector<uint32_t> empty;
+    assert(mt::set_union(empty.begin(), empty.end(), empty.begin(), empty.end(), multiset.begin(), tpool) == multiset.begin());
+
+    // reduce_by_key counts values of every key
+    std::vector<uint32_t> keys(SIZE);
+    for (auto& k: keys) { k = rand() % (SIZE / 8); }
+    mt::sort(keys.begin(), keys.end(), tpool);
+    std::vector<uint64_t> counts(SIZE, 1);
+    std::vector<uint32_t> expected_keys, out_keys(SIZE);
+    std::vector<uint64_t> expected_counts, out_counts(SIZE);
+    for (size_t i = 0; i < SIZE; i++) {
+        if (i == 0 || keys[i] != keys[i - 1]) {
+            expected_keys.push_back(keys[i]);
+            expected_counts.push_back(0);
+        }
+        expected_counts.back()++;
+    }
+    auto ends = mt::reduce_by_key(keys.begin(), keys.end(), counts.begin(), out_keys.begin(), out_counts.begin(), tpool);
+    out_keys.resize(ends.first - out_keys.begin());
+    out_counts.resize(ends.second - out_counts.begin());
+    assert(out_keys == expected_keys && out_counts == expected_counts);
+
+    // a group which spans all parts
+    std::fill(keys.begin(), keys.end(), 5);
+    ends = mt::reduce_by_key(keys.begin(), keys.end(), counts.begin(), out_keys.begin(), out_counts.begin(),
+                             std::equal_to<uint32_t>(), std::plus<uint64_t>(), tpool);
+    assert(ends.first == out_keys.begin() + 1 && out_keys[0] == 5 && out_counts[0] == SIZE);
+
+    // a hot key in the middle, which starts and ends inside of parts, with operations which are not commutative
+    for (size_t i = 0; i < SIZE; i++) {
+        keys[i] = i < SIZE / 8 + 3 ? uint32_t(i / 3) : i < SIZE - SIZE / 8 - 5 ? uint32_t(SIZE) : uint32_t(SIZE + i / 7);
+        counts[i] = i;
+    }
+    auto first_value = [](uint64_t a, uint64_t) { return a; };
+    auto last_value = [](uint64_t, uint64_t b) { return b; };
+    std::vector<uint64_t> lasts(SIZE);
+    ends = mt::reduce_by_key(keys.begin(), keys.end(), counts.begin(), out_keys.begin(), out_counts.begin(),
+                             std::equal_to<uint32_t>(), first_value, tpool);
+    auto last_ends = mt::reduce_by_key(keys.begin(), keys.end(), counts.begin(), out_keys.begin(), lasts.begin(),
+                                       std::equal_to<uint32_t>(), last_value, tpool);
+    size_t group = 0;
+    for (size_t i = 0; i < SIZE; i++) {
+        if (i > 0 && keys[i] == keys[i - 1]) continue;
+        size_t last = i;
+        while (last + 1 < SIZE && keys[last + 1] == keys[i]) last++;
+        assert(out_keys[group] == keys[i] && out_counts[group] == i && lasts[group] == last);
+        group++;
+    }
+    assert(ends.first == out_keys.begin() + group && last_ends.second == lasts.begin() + group);
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_sort_async()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    const size_t batches = 4;
+    std::vector<std::vector<uint32_t>> values(batches, std::vector<uint32_t>(SIZE / batches));
+    for (auto& batch: values) {
+        for (auto& v: batch) { v = rand() % (SIZE / 16); }
+    }
+    std::vector<std::vector<uint32_t>> expected = values;
+    for (auto& batch: expected) {
+        std::sort(batch.begin(), batch.end());
+        batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+    }
+
+    // When:
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<mt::future<size_t>> done;
+    for (auto& batch: values) {
+        typedef std::vector<uint32_t>::iterator iterator;
+        std::vector<uint32_t>* _batch = &batch;
+        mt::thread_pool* pool = &tpool;
+        done.push_back(mt::sort_async(batch.begin(), batch.end(), tpool).then(tpool, [_batch, pool] {
+            return mt::unique(_batch->begin(), _batch->end(), *pool);
+        }).then(tpool, [_batch](iterator last) {
+            _batch->erase(last, _batch->end());
+            return _batch->size();
+        }));
+    }
+    for (size_t i = 0; i < batches; i++) {
+        assert(done[i].get() == expected[i].size());
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> time = end - start;
+
+    // Then:
+    assert(values == expected);
+    fprintf(stderr, "%s: %zu pipelined batches: %0.3fsec\n", __PRETTY_FUNCTION__, batches, time.count());
+
+    // a cancelled sort stops, its continuations are not called
+    std::vector<uint32_t> big(SIZE);
+    for (auto& v: big) { v = rand(); }
+    const uint64_t sum = std::accumulate(big.begin(), big.end(), uint64_t(0));
+    mt::cancellation_token token;
+    bool called = false;
+    auto cancelled = mt::sort_async(big.begin(), big.end(), std::less<uint32_t>(), tpool, token).then(tpool, [&called] { called = true; });
+    token.cancel();
+    bool thrown = false;
+    try {
+        cancelled.get();
+    } catch (const mt::operation_cancelled&) {
+        thrown = true;
+    }
+    assert(thrown && !called && token.is_cancelled());
+    assert(std::accumulate(big.begin(), big.end(), uint64_t(0)) == sum);
+
+    // exceptions of continuations, continuations of ready futures
+    auto failed = mt::unique_async(big.begin(), big.end(), tpool).then(tpool, [](std::vector<uint32_t>::iterator) -> int {
+        throw std::runtime_error("failed");
+    });
+    thrown = false;
+    try {
+        failed.get();
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    mt::future<int> ready = tpool.submit([] { return 20; });
+    ready.wait();
+    assert(ready.then(tpool, [](int v) { return v + 1; }).then(tpool, [](int v) { return v * 2; }).get() == 42);
+    mt::sort_async(big.begin(), big.end()).get();
+    assert(std::is_sorted(big.begin(), big.end()));
+}
+
+struct test_record {
+    uint64_t key;
+    uint64_t order;
+    char payload[112];
+};
+
+template<size_t SIZE = 0x100000>
+static void test_sort_by_key()
+{
+    mt::thread_pool tpool(4);
+    auto key_of = [](const test_record& r) { return r.key; };
+    auto by_key = [](const test_record& r1, const test_record& r2) { return r1.key < r2.key; };
+
+    // Given:
+    std::vector<test_record> actual(SIZE);
+    for (size_t i = 0; i < SIZE; i++) {
+        actual[i].key = uint64_t(rand()) * rand() % (SIZE / 4);
+        actual[i].order = i;
+        memset(actual[i].payload, int(i), sizeof(actual[i].payload));
+    }
+    std::vector<test_record> by_sort = actual;
+    std::vector<test_record> expected = actual;
+    std::stable_sort(expected.begin(), expected.end(), by_key);
+
+    // When:
+    auto sort_start = std::chrono::high_resolution_clock::now();
+    mt::sort(by_sort.begin(), by_sort.end(), by_key, tpool);
+    auto sort_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sort_time = sort_end - sort_start;
+
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    mt::sort_by_key(actual.begin(), actual.end(), key_of, tpool);
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    for (size_t i = 0; i < SIZE; i++) {
+        assert(actual[i].key == expected[i].key && actual[i].order == expected[i].order);
+        assert(actual[i].payload[0] == char(actual[i].order) && actual[i].payload[111] == char(actual[i].order));
+    }
+    fprintf(stderr, "%s: sort: %0.3fsec, sort_by_key: %0.3fsec\n", __PRETTY_FUNCTION__, sort_time.count(), mt_time.count());
+
+    // keys which are not arithmetic and other orders
+    std::vector<std::string> words(0x10000);
+    for (auto& w: words) { w = std::to_string(rand() % 1000); }
+    std::vector<std::string> sorted_words = words;
+    auto length = [](const std::string& w) { return w.size(); };
+    std::stable_sort(sorted_words.begin(), sorted_words.end(), [](const std::string& a, const std::string& b) { return a.size() > b.size(); });
+    const std::vector<size_t> index = mt::sort_index(words.begin(), words.end(), length, std::greater<size_t>(), tpool);
+    for (size_t i = 0; i < words.size(); i++) { assert(words[index[i]] == sorted_words[i]); }
+
+    auto itself = [](const std::string& w) { return w; };
+    sorted_words = words;
+    std::stable_sort(sorted_words.begin(), sorted_words.end());
+    mt::sort_by_key(words.begin(), words.end(), itself, tpool);
+    assert(words == sorted_words);
+
+    std::vector<double> values(0x1000, -1.5);
+    mt::sort_by_key(values.begin(), values.end(), [](double v) { return v; }, std::greater<double>(), tpool);
+    mt::sort_by_key(values.begin(), values.begin(), [](double v) { return v; }, tpool);
+
+    // long double keys aren't radix sorted
+    std::vector<long double> long_doubles(0x1000);
+    for (auto& v: long_doubles) { v = (long double)(rand() % 1000) / 7; }
+    std::vector<long double> sorted_long_doubles = long_doubles;
+    std::stable_sort(sorted_long_doubles.begin(), sorted_long_doubles.end());
+    mt::sort_by_key(long_doubles.begin(), long_doubles.end(), [](long double v) { return v; }, tpool);
+    assert(long_doubles == sorted_long_doubles);
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_stable_sort()
+{
+    typedef std::pair<uint32_t, uint32_t> record; // key, original position
+    auto by_key = [](const record& a, const record& b) { return a.first < b.first; };
+    mt::thread_pool tpool(4);
+    std::vector<record> buffer;
+
+    for (uint32_t distinct: {0x10u, 0x10000u, 0u}) {
+        // Given:
+        std::vector<record> actual(SIZE);
+        for (size_t i = 0; i < SIZE; i++) { actual[i] = record(distinct ? rand() % distinct : rand(), i); }
+        auto expected = actual;
+        auto stl_start = std::chrono::high_resolution_clock::now();
+        std::stable_sort(expected.begin(), expected.end(), by_key);
+        auto stl_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+        // When:
+        auto mt_start = std::chrono::high_resolution_clock::now();
+        mt::stable_sort(actual.begin(), actual.end(), by_key, tpool, buffer);
+        auto mt_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+        // Then: equal keys keep their order
+        assert(actual == expected);
+        fprintf(stderr, "%s: distinct: %u, stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__,
+                distinct, stl_time.count(), mt_time.count());
+    }
+
+    // the buffer is reused
+    const record* memory = buffer.data();
+    std::vector<record> small(SIZE / 2);
+    for (size_t i = 0; i < small.size(); i++) { small[i] = record(rand() % 0x100, i); }
+    mt::stable_sort(small.begin(), small.end(), by_key, tpool, buffer);
+    assert(buffer.data() == memory);
+    for (size_t i = 1; i < small.size(); i++) {
+        assert(small[i - 1].first < small[i].first || (small[i - 1].first == small[i].first && small[i - 1].second < small[i].second));
+    }
+
+    // sizes around part and run bounds
+    for (size_t size = 0; size < 0x100; size++) {
+        std::vector<uint32_t> actual(size * 0x101);
+        for (auto& d: actual) { d = rand(); }
+        auto expected = actual;
+        std::sort(expected.begin(), expected.end());
+        mt::stable_sort(actual.begin(), actual.end(), tpool);
+        assert(actual == expected);
+    }
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_partial_sort()
+{
+    // Given:
+    std::vector<uint32_t> data(SIZE);
+    for (auto& d: data) { d = random_value(); }
+    mt::thread_pool tpool(4);
+
+    for (size_t k: {size_t(1000), SIZE / 0x100, SIZE / 2}) {
+        auto expected = data;
+        auto stl_start = std::chrono::high_resolution_clock::now();
+        std::partial_sort(expected.begin(), expected.begin() + k, expected.end(), std::greater<uint32_t>());
+        auto stl_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+        // When:
+        auto actual = data;
+        auto mt_start = std::chrono::high_resolution_clock::now();
+        mt::partial_sort(actual.begin(), actual.begin() + k, actual.end(), std::greater<uint32_t>(), tpool);
+        auto mt_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+        // Then:
+        assert(std::equal(actual.begin(), actual.begin() + k, expected.begin()));
+        std::sort(actual.begin(), actual.end());
+        std::sort(expected.begin(), expected.end());
+        assert(actual == expected);
+        fprintf(stderr, "%s: k: %zu, stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__, k, stl_time.count(), mt_time.count());
+    }
+}
+
+template<size_t SIZE = 0x100000>
+static void test_nth_element()
+{
+    mt::thread_pool tpool(4);
+
+    for (uint32_t distinct: {0x2u, 0x100u, 0u}) {
+        // Given:
+        std::vector<uint32_t> data(SIZE);
+        for (auto& d: data) { d = distinct ? rand() % distinct : random_value(); }
+        auto sorted = data;
+        std::sort(sorted.begin(), sorted.end());
+
+        for (size_t nth: {size_t(0), size_t(10), SIZE / 3, SIZE - 10, SIZE - 1}) {
+            // When:
+            auto actual = data;
+            mt::nth_element(actual.begin(), actual.begin() + nth, actual.end(), tpool);
+
+            // Then:
+            assert(actual[nth] == sorted[nth]);
+            for (size_t i = 0; i < nth; i++) assert(actual[i] <= actual[nth]);
+            for (size_t i = nth; i < SIZE; i++) assert(actual[i] >= actual[nth]);
+        }
+    }
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_reduce()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    std::vector<uint64_t> data(SIZE);
+    std::iota(data.begin(), data.end(), 0);
+
+    // When:
+    auto stl_start = std::chrono::high_resolution_clock::now();
+    const uint64_t expected = std::accumulate(data.begin(), data.end(), uint64_t(1));
+    auto stl_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    const uint64_t actual = mt::reduce(data.begin(), data.end(), uint64_t(1), tpool);
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    assert(actual == expected);
+    assert(mt::transform_reduce(data.begin(), data.end(), uint64_t(0), std::plus<uint64_t>(), [](uint64_t x) { return x % 3; }, tpool) ==
+           std::accumulate(data.begin(), data.end(), uint64_t(0), [](uint64_t sum, uint64_t x) { return sum + x % 3; }));
+    assert(mt::transform_reduce(data.begin(), data.begin() + 1000, data.begin(), uint64_t(0), tpool) ==
+           std::inner_product(data.begin(), data.begin() + 1000, data.begin(), uint64_t(0)));
+    assert(mt::reduce(data.begin(), data.begin(), uint64_t(7), tpool) == 7);
+    fprintf(stderr, "%s: stl: %0.3fsec, mt: %0.3fsec\n", __PRETTY_FUNCTION__, stl_time.count(), mt_time.count());
+
+    // the order of operands is kept
+    std::vector<std::string> words(0x10000);
+    for (size_t i = 0; i < words.size(); i++) { words[i] = std::to_string(i % 10); }
+    assert(mt::reduce(words.begin(), words.end(), std::string(">"), tpool) == std::accumulate(words.begin(), words.end(), std::string(">")));
+}
+
+template<size_t SIZE = 0x10000000>
+static void test_merge()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    const size_t shards_amount = 8;
+    std::vector<uint32_t> data(SIZE);
+    for (auto& d: data) { d = rand(); }
+    std::vector<std::pair<uint32_t*, uint32_t*>> shards;
+    for (size_t shard = 0; shard < shards_amount; shard++) {
+        uint32_t* from = data.data() + SIZE * shard / shards_amount;
+        uint32_t* to = data.data() + SIZE * (shard + 1) / shards_amount;
+        mt::sort(from, to, tpool);
+        shards.push_back(std::make_pair(from, to));
+    }
+
+    // When:
+    std::vector<uint32_t> expected = data;
+    auto sort_start = std::chrono::high_resolution_clock::now();
+    mt::sort(expected.begin(), expected.end(), tpool);
+    auto sort_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> sort_time = sort_end - sort_start;
+
+    std::vector<uint32_t> actual(SIZE);
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    auto last = mt::merge_k(shards.begin(), shards.end(), actual.begin(), tpool);
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    // Then:
+    assert(last == actual.end());
+    assert(actual == expected);
+    fprintf(stderr, "%s: sort of the shards: %0.3fsec, merge_k: %0.3fsec\n", __PRETTY_FUNCTION__, sort_time.count(), mt_time.count());
+
+    // merges are stable, value is the key, shard is the order
+    typedef std::pair<int, size_t> item;
+    auto by_key = [](const item& a, const item& b) { return a.first < b.first; };
+    for (size_t amount: {size_t(0), size_t(1), size_t(2), size_t(3), size_t(17)}) {
+        std::vector<std::vector<item>> keyed(amount);
+        std::vector<std::pair<const item*, const item*>> ranges;
+        std::vector<item> all;
+        for (size_t shard = 0; shard < amount; shard++) {
+            keyed[shard].resize(shard == 1 ? 0 : rand() % 0x20000);
+            for (auto& k: keyed[shard]) { k = item(rand() % 1000, shard); }
+            std::sort(keyed[shard].begin(), keyed[shard].end(), by_key);
+            ranges.push_back(std::make_pair(keyed[shard].data(), keyed[shard].data() + keyed[shard].size()));
+            all.insert(all.end(), keyed[shard].begin(), keyed[shard].end());
+        }
+        std::vector<item> merged(all.size());
+        assert(mt::merge_k(ranges.begin(), ranges.end(), merged.begin(), by_key, tpool) == merged.end());
+        std::stable_sort(all.begin(), all.end(), by_key);
+        assert(merged == all);
+    }
+    for (size_t size: {size_t(0), size_t(1), size_t(0x100), size_t(0x40000)}) {
+        std::vector<item> a(size), b(size * 3 / 2);
+        for (auto& x: a) { x = item(rand() % 100, 0); }
+        for (auto& x: b) { x = item(rand() % 100, 1); }
+        std::sort(a.begin(), a.end(), by_key);
+        std::sort(b.begin(), b.end(), by_key);
+        std::vector<item> expected_merge(a.size() + b.size());
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), expected_merge.begin(), by_key);
+        std::vector<item> actual_merge(a.size() + b.size());
+        assert(mt::merge(a.begin(), a.end(), b.begin(), b.end(), actual_merge.begin(), by_key, tpool) == actual_merge.end());
+        assert(actual_merge == expected_merge);
+
+        std::vector<item> inplace = a;
+        inplace.insert(inplace.end(), b.begin(), b.end());
+        mt::inplace_merge(inplace.begin(), inplace.begin() + a.size(), inplace.end(), by_key, tpool);
+        assert(inplace == expected_merge);
+    }
+}
+
+template<size_t SIZE = 0x4000000>
+static void test_lower_bound_batch()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    std::vector<uint32_t> data(SIZE);
+    for (auto& d: data) { d = rand() % (SIZE * 2); }
+    std::sort(data.begin(), data.end());
+    std::vector<uint32_t> queries(0x400000);
+    for (auto& q: queries) { q = rand() % (SIZE * 2 + 10); }
+
+    // When:
+    std::vector<size_t> expected(queries.size());
+    auto stl_start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < queries.size(); i++) {
+        expected[i] = std::lower_bound(data.begin(), data.end(), queries[i]) - data.begin();
+    }
+    auto stl_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> stl_time = stl_end - stl_start;
+
+    std::vector<size_t> actual(queries.size());
+    auto mt_start = std::chrono::high_resolution_clock::now();
+    auto last = mt::lower_bound_batch(data.begin(), data.end(), queries.begin(), queries.end(), actual.begin(), tpool);
+    auto mt_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> mt_time = mt_end - mt_start;
+
+    auto index_start = std::chrono::high_resolution_clock::now();
+    mt::eytzinger_index<uint32_t> index(data.begin(), data.end(), tpool);
+    auto index_build = std::chrono::high_resolution_clock::now();
+    std::vector<size_t> by_index(queries.size());
+    index.lower_bound_batch(queries.begin(), queries.end(), by_index.begin(), tpool);
+    auto index_end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> build_time = index_build - index_start;
+    std::chrono::duration<double> index_time = index_end - index_build;
+
+    // Then:
+    assert(last == actual.end());
+    assert(actual == expected);
+    assert(by_index == expected);
+    fprintf(stderr, "%s: stl: %0.3fsec, mt: %0.3fsec, eytzinger: %0.3fsec (build %0.3fsec)\n", __PRETTY_FUNCTION__,
+            stl_time.count(), mt_time.count(), index_time.count(), build_time.count());
+
+    // sorted queries, duplicates and all the small sizes
+    std::sort(queries.begin(), queries.end());
+    mt::lower_bound_batch(data.begin(), data.end(), queries.begin(), queries.end(), actual.begin(), std::less<uint32_t>(), tpool);
+    for (size_t i = 0; i < queries.size(); i++) {
+        assert(actual[i] == size_t(std::lower_bound(data.begin(), data.end(), queries[i]) - data.begin()));
+    }
+    for (size_t size = 0; size < 40; size++) {
+        std::vector<int> small(size);
+        for (auto& s: small) { s = rand() % 8; }
+        std::sort(small.begin(), small.end(), std::greater<int>());
+        std::vector<int> small_queries(0x1000);
+        for (auto& q: small_queries) { q = rand() % 10 - 1; }
+        std::vector<size_t> results(small_queries.size());
+        mt::lower_bound_batch(small.begin(), small.end(), small_queries.begin(), small_queries.end(), results.begin(), std::greater<int>(), tpool);
+        mt::eytzinger_index<int, std::greater<int>> small_index(small.begin(), small.end(), tpool);
+        for (size_t i = 0; i < small_queries.size(); i++) {
+            const size_t position = std::lower_bound(small.begin(), small.end(), small_queries[i], std::greater<int>()) - small.begin();
+            assert(results[i] == position);
+            assert(small_index.lower_bound(small_queries[i]) == position);
+        }
+    }
+
+    // sorted queries greater than all elements, the parts of the second half start exactly at the end
+    std::vector<uint32_t> thousand(1000);
+    for (size_t i = 0; i < thousand.size(); i++) thousand[i] = uint32_t(i * 4);
+    std::vector<uint32_t> beyond(64);
+    for (size_t i = 0; i < beyond.size(); i++) beyond[i] = uint32_t(5000 + i);
+    std::vector<size_t> positions(0x1000);
+    mt::lower_bound_batch(thousand.begin(), thousand.end(), beyond.begin(), beyond.end(), positions.begin(), tpool);
+    for (size_t i = 0; i < beyond.size(); i++) { assert(positions[i] == thousand.size()); }
+    std::vector<uint32_t> halves(0x1000);
+    for (size_t i = 0; i < halves.size(); i++) halves[i] = i < halves.size() / 2 ? uint32_t(i * 4000 / halves.size()) : uint32_t(5000 + i);
+    mt::lower_bound_batch(thousand.begin(), thousand.end(), halves.begin(), halves.end(), positions.begin(), std::less<uint32_t>(), tpool);
+    for (size_t i = 0; i < halves.size(); i++) {
+        assert(positions[i] == size_t(std::lower_bound(thousand.begin(), thousand.end(), halves[i]) - thousand.begin()));
+    }
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_scan()
+{
+    mt::thread_pool tpool(4);
+
+    for (size_t size: {size_t(0), size_t(1), size_t(0x1001), SIZE}) {
+        // Given:
+        std::vector<uint32_t> data(size);
+        for (auto& d: data) { d = rand() % 100; }
+        std::vector<uint32_t> expected(size);
+        std::partial_sum(data.begin(), data.end(), expected.begin());
+
+        // When:
+        std::vector<uint32_t> inclusive(size);
+        auto inclusive_last = mt::inclusive_scan(data.begin(), data.end(), inclusive.begin(), tpool);
+        std::vector<uint32_t> exclusive = data;
+        auto exclusive_last = mt::exclusive_scan(exclusive.begin(), exclusive.end(), exclusive.begin(), uint32_t(5), tpool);
+
+        // Then:
+        assert(inclusive_last == inclusive.end() && exclusive_last == exclusive.end());
+        assert(inclusive == expected);
+        for (size_t i = 0; i < size; i++) {
+            assert(exclusive[i] == 5 + (i ? expected[i - 1] : 0));
+        }
+    }
+}
+
+template<size_t SIZE = 0x1000000>
+static void test_for_each_and_transform()
+{
+    mt::thread_pool tpool(4);
+
+    // Given:
+    std::vector<uint32_t> data(SIZE);
+    std::iota(data.begin(), data.end(), 0);
+
+    // When:
+    mt::for_each(data.begin(), data.end(), [](uint32_t& d) { d *= 2; }, tpool);
+    std::vector<uint64_t> squares(SIZE);
+    auto last = mt::transform(data.begin(), data.end(), squares.begin(), [](uint32_t d) { return uint64_t(d) * d; }, tpool);
+    std::vector<uint64_t> sums(SIZE);
+    mt::transform(squares.begin(), squares.end(), data.begin(), sums.begin(), std::plus<uint64_t>(), tpool);
+    std::vector<uint64_t> differences(SIZE);
+    mt::transform(squares.begin(), squares.end(), data.begin(), differences.begin(), std::minus<uint64_t>());
+    std::atomic<size_t> calls {0};
+    mt::parallel_for(10, 10 + SIZE, [&calls](size_t from, size_t to) { calls += to - from; }, tpool, 1);
+
+    // Then:
+    assert(last == squares.end());
+    assert(calls == SIZE);
+    for (size_t i = 0; i < SIZE; i++) {
+        assert(data[i] == 2 * i && squares[i] == 4 * uint64_t(i) * i && sums[i] == squares[i] + data[i]);
+        assert(differences[i] == squares[i] - data[i]);
+    }
+}
+
 int main()
 {
     test_one_call_without_arg();
@@ -331,17 +2088,62 @@ int main()
     test_one_call_with_args();
     test_a_few_calls_with_args();
 
+    test_one_call_with_submit();
+    test_a_few_calls_with_submit();
+    test_submit_with_exception();
+
+    test_task_group_nested();
+    test_task_groups_sharing_pool();
+    test_task_group_wait_inside_task();
+    test_task_group_with_exception();
+
 #ifdef MT_POOL_RET_SUPPORT
     test_one_call_with_ret();
     test_a_few_calls_with_ret();
 #endif
 
+    test_pool_affinity();
+    test_pool_overhead();
+    test_pool_wake_latency();
+    test_pool_task_throughput();
+
+    test_partition();
+
     test_sort_rand();
+    test_radix_sort_rand<uint32_t>();
+    test_radix_sort_rand<uint64_t>();
+    test_radix_sort_signed_and_float();
     test_sort_sorted();
+    test_sort_presorted();
     test_sort_a_lot_of_duplicates();
+    test_sort_duplicate_ratios();
+    test_sort_shared_pool();
+    test_sort_tuning();
+    test_sort_sample_sort();
+    test_stable_sort();
+    test_sort_by_key();
+    test_external_sort();
+    test_mapped_file();
+    test_scratch_arena();
+    test_pool_stats();
+    test_distinct();
+    test_set_operations();
+    test_sort_async();
+    test_nth_element();
+    test_partial_sort();
+    test_for_each_and_transform();
+    test_reduce();
+    test_scan();
+    test_lower_bound_batch();
+    test_merge();
 
     test_unique();
     test_unique_a_lot_of_duplicates();
+    test_unique_shared_pool();
+    test_unique_compaction();
+    test_unique_simd();
+    test_unique_copy();
+    test_sort_unique();
 
     return 0;
 }
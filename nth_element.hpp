@@ -0,0 +1,332 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/nth_element.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_NTH_ELEMENT_HPP
+#define MT_NTH_ELEMENT_HPP
+
+#include "thread_pool.hpp"
+#include "partition.hpp"
+#include "sort.hpp"
+#include <algorithm>    // for std::nth_element, std::push_heap, std::pop_heap
+#include <iterator>     // for std::iterator_traits
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Up to this amount of the smallest or the biggest elements are selected by heaps
+static const size_t select_max_heap_size = 0x10000;
+
+template<typename Compare>
+struct reverse_compare {
+    Compare& cmp;
+
+    template<typename T>
+    bool operator()(const T& a, const T& b) const { return cmp(b, a); }
+};
+
+/**
+ *  @brief The value of the (k + 1)-th smallest element by @p cmp.
+ *
+ *  Every part of the sequence is scanned by its own task which keeps the
+ *  k + 1 smallest elements of the part in a bounded heap, the value is
+ *  selected from the union of heaps then. The sequence is not modified.
+*/
+template<typename RandomAccessIterator, typename Compare>
+inline typename std::iterator_traits<RandomAccessIterator>::value_type
+select_by_heaps(RandomAccessIterator begin, RandomAccessIterator end, size_t k, Compare& cmp, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    const size_t size = end - begin;
+    const size_t parts_amount = std::max<size_t>(1, std::min(pool.size(), size / partition_min_block_size));
+    std::vector<std::vector<value_type>> heaps(parts_amount);
+    mt::task_group group(pool);
+    for (size_t i = 0; i < parts_amount; i++) {
+        const RandomAccessIterator from = begin + size * i / parts_amount, to = begin + size * (i + 1) / parts_amount;
+        std::vector<value_type>& heap = heaps[i];
+        group.run([from, to, k, &heap, &cmp]{
+            // the biggest of kept elements is on the top
+            heap.reserve(k + 1);
+            for (RandomAccessIterator it = from; it != to; ++it) {
+                if (heap.size() <= k) {
+                    heap.push_back(*it);
+                    std::push_heap(heap.begin(), heap.end(), cmp);
+                } else if (cmp(*it, heap.front())) {
+                    std::pop_heap(heap.begin(), heap.end(), cmp);
+                    heap.back() = *it;
+                    std::push_heap(heap.begin(), heap.end(), cmp);
+                }
+            }
+        });
+    }
+    group.wait();
+
+    std::vector<value_type> candidates;
+    candidates.reserve(parts_amount * (k + 1));
+    for (auto& heap: heaps) {
+        candidates.insert(candidates.end(), std::make_move_iterator(heap.begin()), std::make_move_iterator(heap.end()));
+    }
+    std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end(), cmp);
+    return candidates[k];
+}
+
+// The value of *nth if few elements are on one side of it, otherwise an approximate median
+template<typename RandomAccessIterator, typename Compare>
+inline typename std::iterator_traits<RandomAccessIterator>::value_type
+select_pivot(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool)
+{
+    const size_t size = end - begin;
+    const size_t smaller = nth - begin, bigger = end - nth - 1;
+    if (std::min(smaller, bigger) >= std::min(select_max_heap_size, size / (pool.size() * 16)))
+        return *detail::choose_pivot(begin, end, cmp);
+    if (smaller <= bigger)
+        return detail::select_by_heaps(begin, end, smaller, cmp, pool);
+    detail::reverse_compare<Compare> reverse {cmp};
+    return detail::select_by_heaps(begin, end, bigger, reverse, pool);
+}
+
+template<typename RandomAccessIterator, typename Compare>
+inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    if (nth == end) return;
+
+    while (size_t(end - begin) >= 2 * partition_min_block_size && pool.size() > 1) {
+        const size_t blocks_amount = std::min(pool.size(), size_t(end - begin) / partition_min_block_size);
+        const value_type pivot = detail::select_pivot(begin, nth, end, cmp, pool);
+
+        // only the part which contains nth is processed further, the part of the side of nth is partitioned
+        // the second time, so it is small when the pivot has been found by heaps
+        auto less = [&cmp, &pivot](const value_type& em){ return cmp(em, pivot); };
+        auto not_greater = [&cmp, &pivot](const value_type& em){ return !cmp(pivot, em); };
+        if (nth - begin <= end - nth) {
+            const RandomAccessIterator middle2 = detail::parallel_partition(begin, end, not_greater, pool, blocks_amount);
+            if (nth >= middle2) {
+                begin = middle2;
+                continue;
+            }
+            const RandomAccessIterator middle1 = detail::parallel_partition(begin, middle2, less, pool,
+                                                                            std::min(blocks_amount, size_t(middle2 - begin) / partition_min_block_size));
+            if (nth >= middle1) return; // equal to the pivot
+            end = middle1;
+        } else {
+            const RandomAccessIterator middle1 = detail::parallel_partition(begin, end, less, pool, blocks_amount);
+            if (nth < middle1) {
+                end = middle1;
+                continue;
+            }
+            const RandomAccessIterator middle2 = detail::parallel_partition(middle1, end, not_greater, pool,
+                                                                            std::min(blocks_amount, size_t(end - middle1) / partition_min_block_size));
+            if (nth < middle2) return; // equal to the pivot
+            begin = middle2;
+        }
+    }
+    std::nth_element(begin, nth, end, cmp);
+}
+
+}
+
+/**
+ *  @brief Sort a sequence just enough to find a particular position.
+ *  @param  begin  An iterator linked with first element.
+ *  @param  nth    Another iterator.
+ *  @param  end    Another iterator linked with last element.
+ *  @param  cmp    A comparison functor.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @return  Nothing.
+ *
+ *  Rearranges the elements in the range @p [begin,end) so that @p *nth is
+ *  the same element that would have been in that position had the whole
+ *  sequence been sorted. Elements before it are not greater and elements
+ *  after it are not less than @p *nth.
+ *
+ *  Every step partitions the range in parallel and continues with the part
+ *  which contains @p nth only. If @p nth is close to one of the ends, the
+ *  value of @p *nth is found at once by per thread bounded heaps, so the
+ *  sequence is partitioned only once.
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
+{
+    detail::nth_element(begin, nth, end, cmp, pool);
+}
+
+/**
+ *  @brief Sort a sequence just enough to find a particular position.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  nth             Another iterator.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @param  threads_amount  Amount of thread which may be used for processing.
+ *  @return  Nothing.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, Compare cmp, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    mt::nth_element(begin, nth, end, cmp, pool);
+}
+
+/**
+ *  @brief Sort a sequence just enough to find a particular position.
+ *  @param  begin  An iterator linked with first element.
+ *  @param  nth    Another iterator.
+ *  @param  end    Another iterator linked with last element.
+ *  @param  cmp    A comparison functor.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, Compare cmp)
+{
+    mt::nth_element(begin, nth, end, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    mt::nth_element(begin, nth, end, Compare(), pool);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end, size_t threads_amount)
+{
+    mt::nth_element(begin, nth, end, Compare(), threads_amount);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void nth_element(RandomAccessIterator begin, RandomAccessIterator nth, RandomAccessIterator end)
+{
+    mt::nth_element(begin, nth, end, Compare(), mt::default_pool());
+}
+
+/**
+ *  @brief Sort the smallest elements of a sequence.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  middle  Another iterator.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for processing.
+ *  @return  Nothing.
+ *
+ *  Sorts the smallest @p (middle-begin) elements in the range
+ *  @p [begin,end) and moves them to the range @p [begin,middle). The order
+ *  of the remaining elements in the range @p [middle,end) is undefined.
+ *
+ *  The smallest elements are selected by mt::nth_element(), then they are
+ *  sorted by mt::sort().
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void partial_sort(RandomAccessIterator begin, RandomAccessIterator middle, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
+{
+    if (middle == begin) return;
+    if (middle != end) detail::nth_element(begin, middle - 1, end, cmp, pool);
+    mt::sort(begin, middle, cmp, pool);
+}
+
+/**
+ *  @brief Sort the smallest elements of a sequence.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  middle          Another iterator.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @param  threads_amount  Amount of thread which may be used for processing.
+ *  @return  Nothing.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void partial_sort(RandomAccessIterator begin, RandomAccessIterator middle, RandomAccessIterator end, Compare cmp, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    mt::partial_sort(begin, middle, end, cmp, pool);
+}
+
+/**
+ *  @brief Sort the smallest elements of a sequence.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  middle  Another iterator.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  cmp     A comparison functor.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void partial_sort(RandomAccessIterator begin, RandomAccessIterator middle, RandomAccessIterator end, Compare cmp)
+{
+    mt::partial_sort(begin, middle, end, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void partial_sort(RandomAccessIterator begin, RandomAccessIterator middle, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    mt::partial_sort(begin, middle, end, Compare(), pool);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void partial_sort(RandomAccessIterator begin, RandomAccessIterator middle, RandomAccessIterator end, size_t threads_amount)
+{
+    mt::partial_sort(begin, middle, end, Compare(), threads_amount);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void partial_sort(RandomAccessIterator begin, RandomAccessIterator middle, RandomAccessIterator end)
+{
+    mt::partial_sort(begin, middle, end, Compare(), mt::default_pool());
+}
+
+}
+
+#endif // MT_NTH_ELEMENT_HPP
@@ -0,0 +1,427 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/numeric.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_NUMERIC_HPP
+#define MT_NUMERIC_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include <functional>   // for std::plus, std::multiplies, std::equal_to
+#include <iterator>     // for std::iterator_traits
+#include <utility>      // for std::pair
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Reduces transformed elements of every part separately, parts are not empty
+template<typename T, typename BinaryOperation, typename Transform>
+inline padded_vector<T> reduce_parts(size_t size, size_t parts_amount, const T& init, BinaryOperation& reduce, Transform& transform,
+                                     mt::thread_pool& pool)
+{
+    padded_vector<T> sums(parts_amount, padded<T>(init));
+    detail::for_each_part(size, parts_amount, [&sums, &reduce, &transform](size_t part, size_t from, size_t to) {
+        T sum = transform(from);
+        for (size_t i = from + 1; i < to; i++) {
+            sum = reduce(sum, transform(i));
+        }
+        sums[part].value = sum;
+    }, pool);
+    return sums;
+}
+
+// Reduces init and sums of all parts in order, so reduce doesn't have to be commutative
+template<typename T, typename BinaryOperation, typename Transform>
+inline T ordered_reduce(size_t size, T init, BinaryOperation& reduce, Transform& transform, mt::thread_pool& pool)
+{
+    if (size == 0) return init;
+    const padded_vector<T> sums = detail::reduce_parts(size, detail::parts_amount(size, pool), init, reduce, transform, pool);
+    for (const auto& sum: sums) {
+        init = reduce(init, sum.value);
+    }
+    return init;
+}
+
+}
+
+/**
+ *  @brief Calculate reduction of values in a range.
+ *  @param  begin  A random access iterator.
+ *  @param  end    A random access iterator.
+ *  @param  init   Starting value to add other values to.
+ *  @param  op     An associative binary operation.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @return  The final sum.
+ *
+ *  Every thread reduces its part of the range into its own accumulator,
+ *  which is padded to a cache line, then @p init and accumulators are
+ *  reduced in order. Unlike std::reduce() @p op doesn't have to be
+ *  commutative.
+*/
+template<typename RandomAccessIterator, typename T, typename BinaryOperation>
+CONSTEXPR inline T reduce(RandomAccessIterator begin, RandomAccessIterator end, T init, BinaryOperation op, mt::thread_pool& pool)
+{
+    auto element = [begin](size_t i) -> T { return begin[i]; };
+    return detail::ordered_reduce(std::distance(begin, end), init, op, element, pool);
+}
+
+/**
+ *  @brief Calculate reduction of values in a range.
+ *  @param  begin  A random access iterator.
+ *  @param  end    A random access iterator.
+ *  @param  init   Starting value to add other values to.
+ *  @param  op     An associative binary operation.
+ *  @return  The final sum.
+ *
+ *  The same as above, but mt::default_pool() is used.
+*/
+template<typename RandomAccessIterator, typename T, typename BinaryOperation>
+CONSTEXPR inline T reduce(RandomAccessIterator begin, RandomAccessIterator end, T init, BinaryOperation op)
+{
+    return mt::reduce(begin, end, init, op, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename T>
+CONSTEXPR inline T reduce(RandomAccessIterator begin, RandomAccessIterator end, T init, mt::thread_pool& pool)
+{
+    return mt::reduce(begin, end, init, std::plus<T>(), pool);
+}
+
+template<typename RandomAccessIterator, typename T>
+CONSTEXPR inline T reduce(RandomAccessIterator begin, RandomAccessIterator end, T init)
+{
+    return mt::reduce(begin, end, init, std::plus<T>(), mt::default_pool());
+}
+
+/**
+ *  @brief Calculate reduction of transformed values in a range.
+ *  @param  begin      A random access iterator.
+ *  @param  end        A random access iterator.
+ *  @param  init       Starting value to add other values to.
+ *  @param  reduce     An associative binary operation.
+ *  @param  transform  A unary operation which is applied to every element.
+ *  @param  pool       Thread pool which will be used for processing.
+ *  @return  The final sum.
+ *
+ *  The same as mt::reduce() of transformed values, but no temporary
+ *  sequence is created.
+*/
+template<typename RandomAccessIterator, typename T, typename BinaryOperation, typename UnaryOperation>
+CONSTEXPR inline T transform_reduce(RandomAccessIterator begin, RandomAccessIterator end, T init, BinaryOperation reduce,
+                                    UnaryOperation transform, mt::thread_pool& pool)
+{
+    auto element = [begin, &transform](size_t i) -> T { return transform(begin[i]); };
+    return detail::ordered_reduce(std::distance(begin, end), init, reduce, element, pool);
+}
+
+/**
+ *  @brief Calculate reduction of transformed pairs of values of two ranges.
+ *  @param  begin1     A random access iterator.
+ *  @param  end1       A random access iterator.
+ *  @param  begin2     A random access iterator, the beginning of the second range.
+ *  @param  init       Starting value to add other values to.
+ *  @param  reduce     An associative binary operation.
+ *  @param  transform  A binary operation which is applied to every pair of elements.
+ *  @param  pool       Thread pool which will be used for processing.
+ *  @return  The final sum.
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename T, typename BinaryOperation1, typename BinaryOperation2>
+CONSTEXPR inline T transform_reduce(RandomAccessIterator1 begin1, RandomAccessIterator1 end1, RandomAccessIterator2 begin2, T init,
+                                    BinaryOperation1 reduce, BinaryOperation2 transform, mt::thread_pool& pool)
+{
+    auto element = [begin1, begin2, &transform](size_t i) -> T { return transform(begin1[i], begin2[i]); };
+    return detail::ordered_reduce(std::distance(begin1, end1), init, reduce, element, pool);
+}
+
+/**
+ *  @brief Calculate inner product of two ranges.
+ *  @param  begin1     A random access iterator.
+ *  @param  end1       A random access iterator.
+ *  @param  begin2     A random access iterator, the beginning of the second range.
+ *  @param  init       Starting value to add other values to.
+ *  @param  pool       Thread pool which will be used for processing.
+ *  @return  The final sum.
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename T>
+CONSTEXPR inline T transform_reduce(RandomAccessIterator1 begin1, RandomAccessIterator1 end1, RandomAccessIterator2 begin2, T init,
+                                    mt::thread_pool& pool)
+{
+    return mt::transform_reduce(begin1, end1, begin2, init, std::plus<T>(), std::multiplies<T>(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename T>
+CONSTEXPR inline T transform_reduce(RandomAccessIterator1 begin1, RandomAccessIterator1 end1, RandomAccessIterator2 begin2, T init)
+{
+    return mt::transform_reduce(begin1, end1, begin2, init, mt::default_pool());
+}
+
+/**
+ *  @brief Calculate inclusive prefix sums of a range.
+ *  @param  begin    A random access iterator.
+ *  @param  end      A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  op       An associative binary operation.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Every thread reduces its part first, so the sum of all previous parts
+ *  is known for every part, then parts are scanned independently. The
+ *  destination may be the range itself.
+*/
+template<typename RandomAccessIterator, typename OutputIt, typename BinaryOperation>
+CONSTEXPR inline OutputIt inclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, BinaryOperation op,
+                                         mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    const size_t size = std::distance(begin, end);
+    if (size == 0) return d_first;
+
+    const size_t parts_amount = detail::parts_amount(size, pool);
+    auto element = [begin](size_t i) -> value_type { return begin[i]; };
+    detail::padded_vector<value_type> sums = detail::reduce_parts(size, parts_amount, value_type(*begin), op, element, pool);
+    for (size_t part = 1; part < parts_amount; part++) {
+        sums[part].value = op(sums[part - 1].value, sums[part].value);
+    }
+
+    detail::for_each_part(size, parts_amount, [begin, d_first, &op, &sums](size_t part, size_t from, size_t to) {
+        value_type sum = part == 0 ? value_type(begin[from]) : op(sums[part - 1].value, begin[from]);
+        d_first[from] = sum;
+        for (size_t i = from + 1; i < to; i++) {
+            sum = op(sum, begin[i]);
+            d_first[i] = sum;
+        }
+    }, pool);
+    return d_first + size;
+}
+
+template<typename RandomAccessIterator, typename OutputIt, typename BinaryOperation>
+CONSTEXPR inline OutputIt inclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, BinaryOperation op)
+{
+    return mt::inclusive_scan(begin, end, d_first, op, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename OutputIt>
+CONSTEXPR inline OutputIt inclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, mt::thread_pool& pool)
+{
+    return mt::inclusive_scan(begin, end, d_first, std::plus<typename std::iterator_traits<RandomAccessIterator>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator, typename OutputIt>
+CONSTEXPR inline OutputIt inclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first)
+{
+    return mt::inclusive_scan(begin, end, d_first, mt::default_pool());
+}
+
+/**
+ *  @brief Calculate exclusive prefix sums of a range.
+ *  @param  begin    A random access iterator.
+ *  @param  end      A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  init     The first value of the destination.
+ *  @param  op       An associative binary operation.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as mt::inclusive_scan(), but the i-th sum doesn't include the
+ *  i-th element and starts from @p init.
+*/
+template<typename RandomAccessIterator, typename OutputIt, typename T, typename BinaryOperation>
+CONSTEXPR inline OutputIt exclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, T init, BinaryOperation op,
+                                         mt::thread_pool& pool)
+{
+    const size_t size = std::distance(begin, end);
+    if (size == 0) return d_first;
+
+    const size_t parts_amount = detail::parts_amount(size, pool);
+    auto element = [begin](size_t i) -> T { return begin[i]; };
+    detail::padded_vector<T> sums = detail::reduce_parts(size, parts_amount, init, op, element, pool);
+    // the sum before every part
+    for (size_t part = 0; part < parts_amount; part++) {
+        const T sum = sums[part].value;
+        sums[part].value = init;
+        init = op(init, sum);
+    }
+
+    detail::for_each_part(size, parts_amount, [begin, d_first, &op, &sums](size_t part, size_t from, size_t to) {
+        T sum = sums[part].value;
+        for (size_t i = from; i < to; i++) {
+            T value = begin[i]; // the destination may be the range itself
+            d_first[i] = sum;
+            sum = op(sum, value);
+        }
+    }, pool);
+    return d_first + size;
+}
+
+template<typename RandomAccessIterator, typename OutputIt, typename T, typename BinaryOperation>
+CONSTEXPR inline OutputIt exclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, T init, BinaryOperation op)
+{
+    return mt::exclusive_scan(begin, end, d_first, init, op, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename OutputIt, typename T>
+CONSTEXPR inline OutputIt exclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, T init, mt::thread_pool& pool)
+{
+    return mt::exclusive_scan(begin, end, d_first, init, std::plus<T>(), pool);
+}
+
+template<typename RandomAccessIterator, typename OutputIt, typename T>
+CONSTEXPR inline OutputIt exclusive_scan(RandomAccessIterator begin, RandomAccessIterator end, OutputIt d_first, T init)
+{
+    return mt::exclusive_scan(begin, end, d_first, init, mt::default_pool());
+}
+
+/**
+ *  @brief Reduce values of every group of consecutive equal keys.
+ *  @param  keys_first    A random access iterator of keys.
+ *  @param  keys_last     A random access iterator.
+ *  @param  values_first  A random access iterator of values of the keys.
+ *  @param  keys_out      A random access iterator, the destination of keys.
+ *  @param  values_out    A random access iterator, the destination of sums.
+ *  @param  pred          A binary predicate, an equivalence of keys.
+ *  @param  op            An associative binary operation.
+ *  @param  pool          Thread pool which will be used for processing.
+ *  @return  A pair of iterators designating the ends of both destinations.
+ *
+ *  For every group of consecutive keys for which @p pred returns true the
+ *  first key and the sum of values of the group, reduced by @p op in order,
+ *  are written, e.g. to aggregate sorted (key, value) pairs.
+ *
+ *  It is a segmented reduction: every part reduces only its own elements,
+ *  so a group which spans many parts is reduced by all of them. The head
+ *  of a part, the end of a group which starts before it, is reduced while
+ *  groups are counted. Heads are combined in order by a short serial pass
+ *  over parts, then every part writes the groups which start in it, the
+ *  last one with the heads of the following parts. Counts of groups give
+ *  every part its own offsets of the destinations.
+*/
+template<typename KeyIt, typename ValueIt, typename KeyOutputIt, typename ValueOutputIt, typename BinaryPredicate, typename BinaryOperation>
+CONSTEXPR inline std::pair<KeyOutputIt, ValueOutputIt> reduce_by_key(KeyIt keys_first, KeyIt keys_last, ValueIt values_first,
+                                                                     KeyOutputIt keys_out, ValueOutputIt values_out,
+                                                                     BinaryPredicate pred, BinaryOperation op, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<ValueIt>::value_type value_type;
+    const size_t size = std::distance(keys_first, keys_last);
+    if (size == 0) return std::make_pair(keys_out, values_out);
+    const size_t parts_amount = detail::parts_amount(size, pool);
+    auto starts_group = [keys_first, &pred](size_t i) { return i == 0 || !pred(keys_first[i - 1], keys_first[i]); };
+
+    detail::padded_vector<value_type> heads(parts_amount, detail::padded<value_type>(values_first[0]));
+    std::vector<size_t> head_ends(parts_amount); // the first element of a group which starts in the part
+    std::vector<size_t> offsets(parts_amount + 1);
+    detail::for_each_part(size, parts_amount, [=, &heads, &head_ends, &offsets, &starts_group, &op](size_t part, size_t from, size_t to) {
+        size_t i = from;
+        if (!starts_group(i)) {
+            value_type sum = values_first[i];
+            for (i++; i < to && !starts_group(i); i++) {
+                sum = op(sum, values_first[i]);
+            }
+            heads[part].value = sum;
+        }
+        head_ends[part] = i;
+        size_t groups = 0;
+        for (; i < to; i++) groups += starts_group(i);
+        offsets[part + 1] = groups;
+    }, pool);
+
+    // What follows the last group of every part: heads of the next parts up to the one where a group starts
+    detail::padded_vector<value_type> tails(parts_amount, detail::padded<value_type>(values_first[0]));
+    std::vector<char> continued(parts_amount, false);
+    for (size_t part = parts_amount - 1; part-- > 0;) {
+        const size_t next = part + 1;
+        if (head_ends[next] == size * next / parts_amount) continue; // a group starts the next part
+        tails[part].value = heads[next].value;
+        continued[part] = true;
+        if (offsets[next + 1] == 0 && continued[next]) tails[part].value = op(tails[part].value, tails[next].value);
+    }
+    for (size_t part = 0; part < parts_amount; part++) {
+        offsets[part + 1] += offsets[part];
+    }
+
+    detail::for_each_part(size, parts_amount, [=, &tails, &continued, &head_ends, &offsets, &starts_group, &op](size_t part, size_t, size_t to) {
+        size_t i = head_ends[part];
+        for (size_t out = offsets[part]; i < to; out++) {
+            const size_t first = i;
+            value_type sum = values_first[i];
+            for (i++; i < to && !starts_group(i); i++) {
+                sum = op(sum, values_first[i]);
+            }
+            if (i == to && continued[part]) sum = op(sum, tails[part].value);
+            keys_out[out] = keys_first[first];
+            values_out[out] = sum;
+        }
+    }, pool);
+    return std::make_pair(keys_out + offsets[parts_amount], values_out + offsets[parts_amount]);
+}
+
+template<typename KeyIt, typename ValueIt, typename KeyOutputIt, typename ValueOutputIt, typename BinaryPredicate, typename BinaryOperation>
+CONSTEXPR inline std::pair<KeyOutputIt, ValueOutputIt> reduce_by_key(KeyIt keys_first, KeyIt keys_last, ValueIt values_first,
+                                                                     KeyOutputIt keys_out, ValueOutputIt values_out,
+                                                                     BinaryPredicate pred, BinaryOperation op)
+{
+    return mt::reduce_by_key(keys_first, keys_last, values_first, keys_out, values_out, pred, op, mt::default_pool());
+}
+
+template<typename KeyIt, typename ValueIt, typename KeyOutputIt, typename ValueOutputIt>
+CONSTEXPR inline std::pair<KeyOutputIt, ValueOutputIt> reduce_by_key(KeyIt keys_first, KeyIt keys_last, ValueIt values_first,
+                                                                     KeyOutputIt keys_out, ValueOutputIt values_out, mt::thread_pool& pool)
+{
+    return mt::reduce_by_key(keys_first, keys_last, values_first, keys_out, values_out,
+                             std::equal_to<typename std::iterator_traits<KeyIt>::value_type>(),
+                             std::plus<typename std::iterator_traits<ValueIt>::value_type>(), pool);
+}
+
+template<typename KeyIt, typename ValueIt, typename KeyOutputIt, typename ValueOutputIt>
+CONSTEXPR inline std::pair<KeyOutputIt, ValueOutputIt> reduce_by_key(KeyIt keys_first, KeyIt keys_last, ValueIt values_first,
+                                                                     KeyOutputIt keys_out, ValueOutputIt values_out)
+{
+    return mt::reduce_by_key(keys_first, keys_last, values_first, keys_out, values_out, mt::default_pool());
+}
+
+}
+
+#endif // MT_NUMERIC_HPP
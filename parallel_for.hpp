@@ -0,0 +1,141 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/parallel_for.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_PARALLEL_FOR_HPP
+#define MT_PARALLEL_FOR_HPP
+
+#include "thread_pool.hpp"
+#include <algorithm>    // for std::min, std::max
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Parts of a sequence smaller than this are not worth a separate task
+static const size_t parallel_for_min_part_size = 0x1000;
+
+// Value which takes whole cache lines, so values of different threads don't share them
+template<typename T>
+struct alignas(cache_line_size) padded {
+    T value;
+
+    explicit padded(const T& value) : value(value) {}
+};
+
+template<typename T>
+using padded_vector = std::vector<padded<T>, cache_aligned_allocator<padded<T>>>;
+
+inline size_t parts_amount(size_t size, mt::thread_pool& pool, size_t min_part_size = parallel_for_min_part_size)
+{
+    return std::max<size_t>(1, std::min(pool.size(), size / std::max<size_t>(min_part_size, 1)));
+}
+
+/**
+ *  @brief Call func(part, from, to) for every of @p parts_amount parts of [0, size) by its own task.
+ *
+ *  Parts have nearly equal sizes and go in order of @p part. Waits for all
+ *  parts, the first exception thrown by @p func is rethrown.
+*/
+template<typename Function>
+inline void for_each_part(size_t size, size_t parts_amount, Function func, mt::thread_pool& pool)
+{
+    mt::task_group group(pool);
+    for (size_t part = 0; part < parts_amount; part++) {
+        const size_t from = size * part / parts_amount, to = size * (part + 1) / parts_amount;
+        group.run_at(detail::home_worker(pool, from, size), [&func, part, from, to]{ func(part, from, to); });
+    }
+    group.wait();
+}
+
+}
+
+/**
+ *  @brief Call a function for parts of a range of indexes in parallel.
+ *  @param  begin            The first index.
+ *  @param  end              The index after the last one.
+ *  @param  func             A functor which is called as func(from, to) for every part.
+ *  @param  pool             Thread pool which will be used for processing.
+ *  @param  min_part_size    Parts are not smaller than this, unless the range is.
+ *  @return  Nothing.
+ *
+ *  The range @p [begin,end) is split into at most pool.size() parts of
+ *  nearly equal sizes, every part is processed by its own task. It is the
+ *  building block of the other algorithms, e.g.
+ *  @code
+ *  mt::parallel_for(0, v.size(), [&v](size_t from, size_t to) {
+ *      for (size_t i = from; i < to; i++) v[i] *= 2;
+ *  }, pool);
+ *  @endcode
+*/
+template<typename Function>
+CONSTEXPR inline void parallel_for(size_t begin, size_t end, Function func, mt::thread_pool& pool,
+                                   size_t min_part_size = detail::parallel_for_min_part_size)
+{
+    const size_t size = end > begin ? end - begin : 0;
+    detail::for_each_part(size, detail::parts_amount(size, pool, min_part_size), [begin, &func](size_t, size_t from, size_t to) {
+        func(begin + from, begin + to);
+    }, pool);
+}
+
+/**
+ *  @brief Call a function for parts of a range of indexes in parallel.
+ *  @param  begin            The first index.
+ *  @param  end              The index after the last one.
+ *  @param  func             A functor which is called as func(from, to) for every part.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used.
+*/
+template<typename Function>
+CONSTEXPR inline void parallel_for(size_t begin, size_t end, Function func)
+{
+    mt::parallel_for(begin, end, func, mt::default_pool());
+}
+
+}
+
+#endif // MT_PARALLEL_FOR_HPP
@@ -0,0 +1,204 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/partition.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_PARTITION_HPP
+#define MT_PARTITION_HPP
+
+#include "thread_pool.hpp"
+#include <algorithm>    // for std::partition
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Blocks smaller than this are not worth a separate task
+static const size_t partition_min_block_size = 0x4000;
+
+struct partition_interval {
+    size_t begin;
+    size_t end;
+};
+
+// Swaps misplaced elements with indexes [from, to) of both lists
+template<typename RandomAccessIterator>
+inline void swap_misplaced(RandomAccessIterator begin, const std::vector<partition_interval>& left, const std::vector<partition_interval>& right, size_t from, size_t to)
+{
+    size_t l = 0, r = 0;
+    size_t l_pos = left[0].begin, r_pos = right[0].begin;
+
+    // Find the first elements to swap
+    for (size_t skip = from; skip > 0; ) {
+        size_t step = std::min(skip, left[l].end - l_pos);
+        l_pos += step;
+        skip -= step;
+        if (l_pos == left[l].end && skip > 0) l_pos = left[++l].begin;
+    }
+    for (size_t skip = from; skip > 0; ) {
+        size_t step = std::min(skip, right[r].end - r_pos);
+        r_pos += step;
+        skip -= step;
+        if (r_pos == right[r].end && skip > 0) r_pos = right[++r].begin;
+    }
+
+    for (size_t amount = to - from; amount > 0; ) {
+        if (l_pos == left[l].end) l_pos = left[++l].begin;
+        if (r_pos == right[r].end) r_pos = right[++r].begin;
+        size_t step = std::min(amount, std::min(left[l].end - l_pos, right[r].end - r_pos));
+        std::swap_ranges(begin + l_pos, begin + l_pos + step, begin + r_pos);
+        l_pos += step;
+        r_pos += step;
+        amount -= step;
+    }
+}
+
+/**
+ *  @brief Blocked parallel partition.
+ *
+ *  Every block is partitioned by its own task. After that all elements which
+ *  don't satisfy @p pred and are placed before the final partition point are
+ *  swapped in parallel with elements which satisfy @p pred and are placed
+ *  after it.
+*/
+template<typename RandomAccessIterator, typename Predicate>
+inline RandomAccessIterator parallel_partition(RandomAccessIterator begin, RandomAccessIterator end, Predicate pred, mt::thread_pool& pool, size_t blocks_amount)
+{
+    const size_t size = std::distance(begin, end);
+    if (blocks_amount < 2 || size < blocks_amount * 2) {
+        return std::partition(begin, end, pred);
+    }
+
+    // Partition every block separately
+    const size_t block_size = size / blocks_amount;
+    std::vector<size_t> middles(blocks_amount);
+    mt::task_group group(pool);
+    for (size_t i = 0; i < blocks_amount; i++) {
+        const size_t _begin = block_size * i;
+        const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+        size_t& middle = middles[i];
+        group.run([begin, _begin, _end, &middle, &pred]{
+            middle = std::distance(begin, std::partition(begin + _begin, begin + _end, pred));
+        });
+    }
+    group.wait();
+
+    size_t middle = 0;
+    for (size_t i = 0; i < blocks_amount; i++) {
+        middle += middles[i] - block_size * i;
+    }
+
+    // Collect misplaced elements at both sides of the partition point
+    std::vector<partition_interval> left, right;
+    size_t misplaced = 0;
+    for (size_t i = 0; i < blocks_amount; i++) {
+        const size_t _begin = block_size * i;
+        const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+        const size_t _middle = middles[i];
+        if (_middle < middle) {
+            partition_interval interval {_middle, std::min(_end, middle)};
+            if (interval.begin < interval.end) {
+                left.push_back(interval);
+                misplaced += interval.end - interval.begin;
+            }
+        }
+        if (_middle > middle) {
+            partition_interval interval {std::max(_begin, middle), _middle};
+            if (interval.begin < interval.end) right.push_back(interval);
+        }
+    }
+
+    // Swap them by equal parts
+    const size_t tasks_amount = std::min(blocks_amount, (misplaced + partition_min_block_size - 1) / partition_min_block_size);
+    for (size_t i = 0; i < tasks_amount; i++) {
+        const size_t from = misplaced * i / tasks_amount;
+        const size_t to = misplaced * (i + 1) / tasks_amount;
+        group.run([begin, &left, &right, from, to]{ swap_misplaced(begin, left, right, from, to); });
+    }
+    group.wait();
+
+    return begin + middle;
+}
+
+}
+
+/**
+ *  @brief Move elements for which a predicate is true to the beginning
+ *         of a sequence.
+ *  @param  begin  A forward iterator.
+ *  @param  end    A forward iterator.
+ *  @param  pred   A predicate functor.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @return  An iterator @p middle such that @p pred(i) is true for each
+ *  iterator @p i in the range @p [begin,middle) and false for each @p i
+ *  in the range @p [middle,end).
+ *
+ *  @p pred may be called concurrently from several threads.
+ *  The relative ordering of elements is not preserved.
+*/
+template<typename RandomAccessIterator, typename Predicate>
+CONSTEXPR inline RandomAccessIterator partition(RandomAccessIterator begin, RandomAccessIterator end, Predicate pred, mt::thread_pool& pool)
+{
+    const size_t size = std::distance(begin, end);
+    const size_t blocks_amount = std::min(pool.size(), size / detail::partition_min_block_size);
+    return detail::parallel_partition(begin, end, pred, pool, blocks_amount);
+}
+
+template<typename RandomAccessIterator, typename Predicate>
+CONSTEXPR inline RandomAccessIterator partition(RandomAccessIterator begin, RandomAccessIterator end, Predicate pred, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    return mt::partition(begin, end, pred, pool);
+}
+
+template<typename RandomAccessIterator, typename Predicate>
+CONSTEXPR inline RandomAccessIterator partition(RandomAccessIterator begin, RandomAccessIterator end, Predicate pred)
+{
+    return mt::partition(begin, end, pred, mt::default_pool());
+}
+
+}
+
+#endif // MT_PARTITION_HPP
@@ -0,0 +1,186 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/pool_stats.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_POOL_STATS_HPP
+#define MT_POOL_STATS_HPP
+
+#include <algorithm>    // for std::max
+#include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono::nanoseconds
+#include <cstdint>      // for int64_t
+#include <mutex>        // for std::mutex
+#include <ostream>      // for std::ostream
+#include <vector>       // for std::vector
+
+namespace mt {
+
+// Bucket i of worker_stats::latency counts tasks which started in [2^(i-1), 2^i) microseconds after they were pushed
+static const size_t latency_buckets = 16;
+
+/**
+ *  @brief Counters of a thread of mt::thread_pool, see thread_pool::stats().
+ *
+ *  Times are sums over the thread's life since the last reset: busy is spent
+ *  in tasks, idle — in spinning and yielding while waiting for tasks,
+ *  parked — in sleeping, a wait is counted when it is over. The last latency
+ *  bucket keeps all longer latencies.
+*/
+struct worker_stats {
+    size_t tasks {0};           // executed tasks
+    size_t steals {0};          // tasks taken from queues of other workers
+    size_t max_queue_depth {0}; // of the own queue
+    std::chrono::nanoseconds busy {0};
+    std::chrono::nanoseconds idle {0};
+    std::chrono::nanoseconds parked {0};
+    size_t latency[latency_buckets] {}; // push-to-start latency histogram
+
+    worker_stats& operator+=(const worker_stats& other) {
+        tasks += other.tasks;
+        steals += other.steals;
+        max_queue_depth = std::max(max_queue_depth, other.max_queue_depth);
+        busy += other.busy;
+        idle += other.idle;
+        parked += other.parked;
+        for (size_t i = 0; i < latency_buckets; i++) latency[i] += other.latency[i];
+        return *this;
+    }
+};
+
+/**
+ *  @brief Snapshot of counters of mt::thread_pool.
+ *
+ *  Threads which wait for a task_group and run tasks meanwhile are counted
+ *  together as @p helpers, tasks pushed from outside of the pool are queued
+ *  in the queue whose depth is @p helpers.max_queue_depth.
+*/
+struct pool_stats {
+    std::vector<worker_stats> workers;
+    worker_stats helpers;
+
+    worker_stats total() const {
+        worker_stats result = helpers;
+        for (const worker_stats& w: workers) result += w;
+        return result;
+    }
+};
+
+// Span of a task in a trace, times are from the start of tracing
+struct trace_event {
+    size_t thread; // worker index, thread_pool::size() for helpers
+    std::chrono::nanoseconds start;
+    std::chrono::nanoseconds duration;
+};
+
+/**
+ *  @brief Write task spans in the Chrome trace event format.
+ *
+ *  The result can be opened by chrome://tracing or Perfetto, every worker
+ *  is a thread there, so gaps show idle workers and imbalance of parts.
+*/
+inline void write_chrome_trace(std::ostream& out, const std::vector<trace_event>& events)
+{
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        const trace_event& e = events[i];
+        out << (i ? ",\n" : "\n") << "{\"name\":\"task\",\"cat\":\"mt\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread
+            << ",\"ts\":" << e.start.count() / 1000.0 << ",\"dur\":" << e.duration.count() / 1000.0 << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+namespace detail {
+
+// Counters of a thread, they are written by relaxed atomics and may be read at any time
+struct alignas(64) stats_slot {
+    std::atomic<size_t> tasks {0};
+    std::atomic<size_t> steals {0};
+    std::atomic<size_t> max_queue_depth {0};
+    std::atomic<int64_t> busy {0};
+    std::atomic<int64_t> idle {0};
+    std::atomic<int64_t> parked {0};
+    std::atomic<size_t> latency[latency_buckets];
+    mutable std::mutex trace_mutex;
+    std::vector<trace_event> trace; // guarded by trace_mutex
+
+    stats_slot() {
+        for (auto& bucket: latency) bucket = 0;
+    }
+
+    void add(std::atomic<size_t>& counter, size_t value) {
+        counter.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void add(std::atomic<int64_t>& counter, std::chrono::nanoseconds time) {
+        counter.fetch_add(time.count(), std::memory_order_relaxed);
+    }
+
+    void add_latency(std::chrono::nanoseconds time) {
+        size_t bucket = 0;
+        for (int64_t us = time.count() / 1000; us > 0 && bucket + 1 < latency_buckets; us >>= 1) bucket++;
+        add(latency[bucket], 1);
+    }
+
+    void update_depth(size_t depth) {
+        size_t current = max_queue_depth.load(std::memory_order_relaxed);
+        while (depth > current && !max_queue_depth.compare_exchange_weak(current, depth, std::memory_order_relaxed)) {}
+    }
+
+    worker_stats snapshot() const {
+        worker_stats result;
+        result.tasks = tasks.load(std::memory_order_relaxed);
+        result.steals = steals.load(std::memory_order_relaxed);
+        result.max_queue_depth = max_queue_depth.load(std::memory_order_relaxed);
+        result.busy = std::chrono::nanoseconds(busy.load(std::memory_order_relaxed));
+        result.idle = std::chrono::nanoseconds(idle.load(std::memory_order_relaxed));
+        result.parked = std::chrono::nanoseconds(parked.load(std::memory_order_relaxed));
+        for (size_t i = 0; i < latency_buckets; i++) result.latency[i] = latency[i].load(std::memory_order_relaxed);
+        return result;
+    }
+
+    void reset() {
+        tasks = steals = max_queue_depth = 0;
+        busy = idle = parked = 0;
+        for (auto& bucket: latency) bucket = 0;
+    }
+};
+
+}
+
+}
+
+#endif // MT_POOL_STATS_HPP
@@ -0,0 +1,254 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/radix_sort.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_RADIX_SORT_HPP
+#define MT_RADIX_SORT_HPP
+
+#include "thread_pool.hpp"
+#include <algorithm>    // for std::move
+#include <vector>       // for std::vector
+#include <cstdint>      // for uint32_t
+#include <cstring>      // for memcpy
+#include <limits>       // for std::numeric_limits
+#include <type_traits>  // for std::integral_constant
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+static const size_t radix_bits = 8;
+static const size_t radix_buckets = 1 << radix_bits;
+static const size_t radix_min_block_size = 0x10000;
+
+template<size_t Size> struct unsigned_of_size;
+template<> struct unsigned_of_size<1> { typedef uint8_t type; };
+template<> struct unsigned_of_size<2> { typedef uint16_t type; };
+template<> struct unsigned_of_size<4> { typedef uint32_t type; };
+template<> struct unsigned_of_size<8> { typedef uint64_t type; };
+
+// Integers and floating point values which fit an unsigned integer, e.g. not long double
+template<typename T>
+struct is_radix_sortable : std::integral_constant<bool, std::is_integral<T>::value ||
+    (std::is_floating_point<T>::value && sizeof(T) <= sizeof(uint64_t))> {};
+
+/**
+ *  @brief Maps an arithmetic value to an unsigned integer with the same order.
+ *
+ *  Sign bit of signed integers is flipped. Negative floating point values
+ *  have all bits flipped and positive ones have the sign bit flipped only.
+*/
+template<typename T, bool = std::is_floating_point<T>::value, bool = std::is_signed<T>::value>
+struct radix_key {
+    typedef typename unsigned_of_size<sizeof(T)>::type type;
+    type operator()(T value) const { return static_cast<type>(value); }
+};
+
+template<typename T>
+struct radix_key<T, false, true> {
+    typedef typename unsigned_of_size<sizeof(T)>::type type;
+    type operator()(T value) const {
+        return static_cast<type>(value) ^ (type(1) << (sizeof(T) * 8 - 1));
+    }
+};
+
+template<typename T>
+struct radix_key<T, true, true> {
+    typedef typename unsigned_of_size<sizeof(T)>::type type;
+    type operator()(T value) const {
+        type bits;
+        memcpy(&bits, &value, sizeof(bits));
+        const type sign = type(1) << (sizeof(T) * 8 - 1);
+        return bits & sign ? ~bits : bits ^ sign;
+    }
+};
+
+// Inverts the order of another key
+template<typename Key>
+struct reverse_radix_key {
+    typedef typename Key::type type;
+    Key key;
+    template<typename T>
+    type operator()(const T& value) const { return ~key(value); }
+};
+
+template<typename Iterator, typename Key>
+inline void radix_count(Iterator begin, Iterator end, const Key& key, size_t shift, size_t* counts)
+{
+    for (; begin != end; ++begin) {
+        counts[(key(*begin) >> shift) & (radix_buckets - 1)]++;
+    }
+}
+
+template<typename Iterator, typename OutputIterator, typename Key>
+inline void radix_scatter(Iterator begin, Iterator end, OutputIterator result, const Key& key, size_t shift, size_t* offsets)
+{
+    for (; begin != end; ++begin) {
+        *(result + offsets[(key(*begin) >> shift) & (radix_buckets - 1)]++) = std::move(*begin);
+    }
+}
+
+/**
+ *  @brief Parallel LSD radix sort by an unsigned integer key.
+ *  @param  key  Functor which returns unsigned integer key of an element.
+ *
+ *  Every pass takes 8 bits of the key. Blocks of the input count their
+ *  histograms in parallel, an exclusive prefix sum over (digit, block)
+ *  gives every block its own place inside of every digit and the blocks
+ *  are scattered in parallel. Passes where all keys have the same digit
+ *  are skipped.
+*/
+template<typename RandomAccessIterator, typename Key>
+inline void radix_sort(RandomAccessIterator begin, RandomAccessIterator end, Key key, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    typedef typename Key::type key_type;
+
+    const size_t size = std::distance(begin, end);
+    if (size < 2) return;
+
+    const size_t blocks_amount = std::max<size_t>(1, std::min(pool.size(), size / radix_min_block_size));
+    const size_t block_size = size / blocks_amount;
+    scratch_buffer<value_type> buffer(pool.scratch(), size);
+    std::vector<size_t> counts(blocks_amount * radix_buckets);
+    mt::task_group group(pool);
+
+    bool in_buffer = false;
+    for (size_t shift = 0; shift < sizeof(key_type) * 8; shift += radix_bits) {
+        std::fill(counts.begin(), counts.end(), 0);
+
+        // Count digits of every block
+        for (size_t i = 0; i < blocks_amount; i++) {
+            const size_t _begin = block_size * i;
+            const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+            group.run([=, &buffer, &counts, &key]{
+                size_t* _counts = &counts[i * radix_buckets];
+                if (in_buffer) {
+                    radix_count(buffer.begin() + _begin, buffer.begin() + _end, key, shift, _counts);
+                } else {
+                    radix_count(begin + _begin, begin + _end, key, shift, _counts);
+                }
+            });
+        }
+        group.wait();
+
+        // Exclusive prefix sum in digit-major order
+        size_t offset = 0;
+        bool trivial = false;
+        for (size_t digit = 0; digit < radix_buckets; digit++) {
+            const size_t digit_begin = offset;
+            for (size_t i = 0; i < blocks_amount; i++) {
+                size_t count = counts[i * radix_buckets + digit];
+                counts[i * radix_buckets + digit] = offset;
+                offset += count;
+            }
+            if (offset - digit_begin == size) trivial = true;
+        }
+        if (trivial) continue; // all keys have the same digit
+
+        // Scatter
+        for (size_t i = 0; i < blocks_amount; i++) {
+            const size_t _begin = block_size * i;
+            const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+            group.run([=, &buffer, &counts, &key]{
+                size_t* offsets = &counts[i * radix_buckets];
+                if (in_buffer) {
+                    radix_scatter(buffer.begin() + _begin, buffer.begin() + _end, begin, key, shift, offsets);
+                } else {
+                    radix_scatter(begin + _begin, begin + _end, buffer.begin(), key, shift, offsets);
+                }
+            });
+        }
+        group.wait();
+        in_buffer = !in_buffer;
+    }
+
+    if (in_buffer) {
+        for (size_t i = 0; i < blocks_amount; i++) {
+            const size_t _begin = block_size * i;
+            const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+            group.run([=, &buffer]{ std::move(buffer.begin() + _begin, buffer.begin() + _end, begin + _begin); });
+        }
+        group.wait();
+    }
+}
+
+}
+
+/**
+ *  @brief Sort the elements of a sequence of arithmetic values.
+ *  @param  begin  An iterator linked with first element.
+ *  @param  end    Another iterator linked with last element.
+ *  @param  pool   Thread pool which will be used for sorting.
+ *  @return  Nothing.
+ *
+ *  Sorts the elements in the range @p [begin,end) in ascending order by
+ *  parallel LSD radix sort. Signed and floating point values are supported.
+ *  Temporary buffer of the same size as the range is taken from pool.scratch().
+*/
+template<typename RandomAccessIterator>
+CONSTEXPR inline void radix_sort(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    static_assert(detail::is_radix_sortable<value_type>::value, "mt::radix_sort() requires integral, float or double values");
+    detail::radix_sort(begin, end, detail::radix_key<value_type>(), pool);
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline void radix_sort(RandomAccessIterator begin, RandomAccessIterator end, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    mt::radix_sort(begin, end, pool);
+}
+
+template<typename RandomAccessIterator>
+CONSTEXPR inline void radix_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    mt::radix_sort(begin, end, mt::default_pool());
+}
+
+}
+
+#endif // MT_RADIX_SORT_HPP
@@ -0,0 +1,167 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/sample_sort.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_SAMPLE_SORT_HPP
+#define MT_SAMPLE_SORT_HPP
+
+#include "thread_pool.hpp"
+#include <algorithm>    // for std::sort
+#include <vector>       // for std::vector
+#include <cstdint>      // for uint16_t
+
+namespace mt {
+
+namespace detail {
+
+static const size_t sample_sort_max_splitters = 1023;
+static const size_t sample_sort_oversampling = 16;
+static const size_t sample_sort_min_block_size = 0x10000;
+
+/**
+ *  @brief Parallel samplesort.
+ *
+ *  Splitters are chosen from a sorted random sample. Every element is
+ *  classified with a binary search over the splitters, elements equal to a
+ *  splitter go to a separate bucket which doesn't need sorting at all, so
+ *  a lot of duplicates doesn't make buckets uneven. Blocks of the input
+ *  are classified and scattered into a temporary buffer in parallel, then
+ *  every bucket is sorted by its own task and moved back.
+*/
+template<typename RandomAccessIterator, typename Compare>
+inline void sample_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    typedef uint16_t bucket_t;
+
+    const size_t size = std::distance(begin, end);
+    const size_t splitters_amount = std::min(sample_sort_max_splitters, pool.size() * 8 - 1);
+    if (size < sample_sort_min_block_size || splitters_amount == 0) {
+        std::sort(begin, end, cmp);
+        return;
+    }
+
+    // Take a sample by a simple xorshift generator
+    std::vector<value_type> splitters;
+    splitters.reserve(sample_sort_oversampling * (splitters_amount + 1));
+    uint64_t seed = size * 0x9E3779B97F4A7C15ull | 1;
+    for (size_t i = 0; i < sample_sort_oversampling * (splitters_amount + 1); i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        splitters.push_back(*(begin + seed % size));
+    }
+    std::sort(splitters.begin(), splitters.end(), cmp);
+    for (size_t i = 0; i < splitters_amount; i++) {
+        splitters[i] = splitters[(i + 1) * sample_sort_oversampling];
+    }
+    splitters.resize(splitters_amount);
+    splitters.erase(std::unique(splitters.begin(), splitters.end(),
+                                [&cmp](const value_type& a, const value_type& b){ return !cmp(a, b); }), splitters.end());
+
+    // Bucket 2*i keeps elements between splitters i-1 and i, bucket 2*i+1 keeps elements equal to splitter i
+    const size_t buckets_amount = splitters.size() * 2 + 1;
+    const size_t blocks_amount = std::min(pool.size() * 4, size / sample_sort_min_block_size + 1);
+    const size_t block_size = size / blocks_amount;
+    scratch_buffer<bucket_t> buckets(pool.scratch(), size);
+    std::vector<size_t> counts(blocks_amount * buckets_amount);
+    mt::task_group group(pool);
+
+    // Classify
+    for (size_t i = 0; i < blocks_amount; i++) {
+        const size_t _begin = block_size * i;
+        const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+        group.run([=, &splitters, &buckets, &counts, &cmp]{
+            size_t* _counts = &counts[i * buckets_amount];
+            for (size_t j = _begin; j < _end; j++) {
+                const value_type& em = *(begin + j);
+                const size_t splitter = std::lower_bound(splitters.begin(), splitters.end(), em, cmp) - splitters.begin();
+                const size_t bucket = splitter * 2 + (splitter < splitters.size() && !cmp(em, splitters[splitter]));
+                buckets[j] = bucket;
+                _counts[bucket]++;
+            }
+        });
+    }
+    group.wait();
+
+    // Exclusive prefix sum in bucket-major order gives every block its place inside of every bucket
+    std::vector<size_t> bucket_begins(buckets_amount + 1);
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < buckets_amount; bucket++) {
+        bucket_begins[bucket] = offset;
+        for (size_t i = 0; i < blocks_amount; i++) {
+            size_t count = counts[i * buckets_amount + bucket];
+            counts[i * buckets_amount + bucket] = offset;
+            offset += count;
+        }
+    }
+    bucket_begins[buckets_amount] = size;
+
+    // Scatter
+    scratch_buffer<value_type> buffer(pool.scratch(), size);
+    for (size_t i = 0; i < blocks_amount; i++) {
+        const size_t _begin = block_size * i;
+        const size_t _end = i == blocks_amount - 1 ? size : _begin + block_size;
+        group.run([=, &buckets, &counts, &buffer]{
+            size_t* offsets = &counts[i * buckets_amount];
+            for (size_t j = _begin; j < _end; j++) {
+                buffer[offsets[buckets[j]]++] = std::move(*(begin + j));
+            }
+        });
+    }
+    group.wait();
+
+    // Sort buckets and move them back
+    for (size_t bucket = 0; bucket < buckets_amount; bucket++) {
+        const size_t _begin = bucket_begins[bucket];
+        const size_t _end = bucket_begins[bucket + 1];
+        if (_begin == _end) continue;
+        group.run([=, &buffer, &cmp]{
+            if (bucket % 2 == 0) {
+                std::sort(buffer.begin() + _begin, buffer.begin() + _end, cmp);
+            }
+            std::move(buffer.begin() + _begin, buffer.begin() + _end, begin + _begin);
+        });
+    }
+    group.wait();
+}
+
+}
+
+}
+
+#endif // MT_SAMPLE_SORT_HPP
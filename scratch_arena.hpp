@@ -0,0 +1,280 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/scratch_arena.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_SCRATCH_ARENA_HPP
+#define MT_SCRATCH_ARENA_HPP
+
+#include <algorithm>    // for std::max
+#include <cstdint>      // for uintptr_t
+#include <mutex>        // for std::mutex
+#include <new>          // for ::operator new
+#include <type_traits>  // for std::is_trivially_default_constructible
+#include <vector>       // for std::vector
+#ifdef __linux__
+#include <sys/mman.h>   // for mmap, madvise
+#endif
+
+// Default limit of memory which mt::scratch_arena keeps between calls
+#ifndef MT_SCRATCH_ARENA_CAP_BYTES
+#define MT_SCRATCH_ARENA_CAP_BYTES 0x40000000
+#endif
+
+namespace mt {
+
+namespace detail {
+
+static const size_t scratch_alignment = 64;
+static const size_t scratch_huge_page_size = 0x200000;
+
+// Blocks of huge pages size and bigger are mapped on huge page boundaries, so they can be backed by huge pages
+inline void* allocate_scratch(size_t bytes)
+{
+#ifdef __linux__
+    if (bytes >= scratch_huge_page_size) {
+        const size_t mapped = bytes + scratch_huge_page_size;
+        void* address = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address == MAP_FAILED) throw std::bad_alloc();
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(address);
+        const uintptr_t aligned = (begin + scratch_huge_page_size - 1) & ~uintptr_t(scratch_huge_page_size - 1);
+        if (aligned != begin) munmap(address, aligned - begin);
+        if (aligned + bytes != begin + mapped) munmap(reinterpret_cast<void*>(aligned + bytes), begin + mapped - aligned - bytes);
+#ifdef MADV_HUGEPAGE
+        madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<void*>(aligned);
+    }
+#endif
+    // Keep original pointer right before the aligned block to be able to release it
+    char* raw = static_cast<char*>(::operator new(bytes + scratch_alignment + sizeof(void*)));
+    uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + scratch_alignment - 1) & ~uintptr_t(scratch_alignment - 1);
+    reinterpret_cast<void**>(aligned)[-1] = raw;
+    return reinterpret_cast<void*>(aligned);
+}
+
+inline void free_scratch(void* data, size_t bytes)
+{
+#ifdef __linux__
+    if (bytes >= scratch_huge_page_size) {
+        munmap(data, bytes);
+        return;
+    }
+#endif
+    ::operator delete(reinterpret_cast<void**>(data)[-1]);
+}
+
+}
+
+/**
+ *  @brief Cache of scratch memory of algorithms.
+ *
+ *  Algorithms which need temporary buffers of the size of their input,
+ *  e.g. mt::radix_sort() or mt::stable_sort(), take them from the arena of
+ *  their pool, see thread_pool::scratch(). Released blocks are kept with
+ *  their pages faulted in, so repeated calls of the same sizes don't
+ *  allocate memory. Blocks of 2MB and bigger are requested to be backed
+ *  by transparent huge pages.
+ *
+ *  Free blocks are kept while all blocks take at most @p cap bytes, a
+ *  block which doesn't fit is freed when it is released. shrink() frees
+ *  free blocks on request. It is thread safe.
+*/
+class scratch_arena {
+public:
+    scratch_arena(const scratch_arena&) = delete;
+    scratch_arena& operator=(const scratch_arena&) = delete;
+
+    explicit scratch_arena(size_t cap_bytes = MT_SCRATCH_ARENA_CAP_BYTES) : cap(cap_bytes) {}
+
+    ~scratch_arena() {
+        for (const block& b: blocks) detail::free_scratch(b.data, b.bytes);
+    }
+
+    // Returns memory for at least @p bytes, aligned to a cache line, the smallest free block which is big enough is reused
+    void* acquire(size_t bytes) {
+        if (bytes == 0) return nullptr;
+        const size_t granularity = bytes >= detail::scratch_huge_page_size ? detail::scratch_huge_page_size : detail::scratch_alignment;
+        bytes = (bytes + granularity - 1) / granularity * granularity;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            block* best = nullptr;
+            for (block& b: blocks) {
+                if (!b.used && b.bytes >= bytes && (!best || b.bytes < best->bytes)) best = &b;
+            }
+            if (best) {
+                best->used = true;
+                return best->data;
+            }
+        }
+        void* data = detail::allocate_scratch(bytes);
+        std::lock_guard<std::mutex> lock(mutex);
+        blocks.push_back(block {data, bytes, true});
+        total += bytes;
+        system_allocations++;
+        trim(cap);
+        return data;
+    }
+
+    // Returns memory which has been acquired
+    void release(void* data) {
+        if (!data) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (block& b: blocks) {
+            if (b.data == data) b.used = false;
+        }
+        trim(cap);
+    }
+
+    // Frees free blocks until all blocks take at most @p keep_bytes
+    void shrink(size_t keep_bytes = 0) {
+        std::lock_guard<std::mutex> lock(mutex);
+        trim(keep_bytes);
+    }
+
+    void set_cap(size_t cap_bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        cap = cap_bytes;
+        trim(cap);
+    }
+
+    size_t cap_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cap;
+    }
+
+    // Memory of free and used blocks
+    size_t size_bytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return total;
+    }
+
+    // Amount of blocks which have been allocated from the system
+    size_t allocations() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return system_allocations;
+    }
+
+private:
+    struct block {
+        void* data;
+        size_t bytes;
+        bool used;
+    };
+
+    // Frees the biggest free blocks first. mutex must be locked.
+    void trim(size_t limit) {
+        while (total > limit) {
+            auto biggest = blocks.end();
+            for (auto b = blocks.begin(); b != blocks.end(); ++b) {
+                if (!b->used && (biggest == blocks.end() || b->bytes > biggest->bytes)) biggest = b;
+            }
+            if (biggest == blocks.end()) return;
+            detail::free_scratch(biggest->data, biggest->bytes);
+            total -= biggest->bytes;
+            blocks.erase(biggest);
+        }
+    }
+
+    mutable std::mutex mutex;
+    std::vector<block> blocks;
+    size_t total {0};
+    size_t system_allocations {0};
+    size_t cap;
+};
+
+/**
+ *  @brief Array of @p size elements in memory of mt::scratch_arena.
+ *
+ *  Elements are default-initialized, i.e. they are not zeroed if they are
+ *  trivial, and the memory goes back to the arena when it is destroyed.
+ *  Memory for @p capacity elements is taken if it is bigger, so calls with
+ *  slightly different sizes can reuse the same block.
+*/
+template<typename T>
+class scratch_buffer {
+public:
+    static_assert(alignof(T) <= detail::scratch_alignment, "mt::scratch_buffer supports alignment up to a cache line");
+
+    scratch_buffer(const scratch_buffer&) = delete;
+    scratch_buffer& operator=(const scratch_buffer&) = delete;
+
+    scratch_buffer(scratch_arena& arena, size_t size, size_t capacity = 0)
+        : arena(arena), elements(static_cast<T*>(arena.acquire(std::max(size, capacity) * sizeof(T)))), amount(0) {
+        try {
+            construct(size, std::is_trivially_default_constructible<T>());
+        } catch (...) {
+            destroy(std::is_trivially_destructible<T>());
+            arena.release(elements);
+            throw;
+        }
+    }
+
+    ~scratch_buffer() {
+        destroy(std::is_trivially_destructible<T>());
+        arena.release(elements);
+    }
+
+    T* begin() { return elements; }
+    T* end() { return elements + amount; }
+    T* data() { return elements; }
+    T& operator[](size_t i) { return elements[i]; }
+    const T& operator[](size_t i) const { return elements[i]; }
+    size_t size() const { return amount; }
+
+private:
+    void construct(size_t size, std::true_type) {
+        amount = size;
+    }
+
+    void construct(size_t size, std::false_type) {
+        for (; amount < size; amount++) new (elements + amount) T;
+    }
+
+    void destroy(std::true_type) {}
+
+    void destroy(std::false_type) {
+        for (size_t i = 0; i < amount; i++) elements[i].~T();
+    }
+
+    scratch_arena& arena;
+    T* elements;
+    size_t amount;
+};
+
+}
+
+#endif // MT_SCRATCH_ARENA_HPP
@@ -0,0 +1,281 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/search.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_SEARCH_HPP
+#define MT_SEARCH_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include <algorithm>    // for std::is_sorted, std::lower_bound
+#include <functional>   // for std::less
+#include <iterator>     // for std::iterator_traits
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Searches which are done at once by one thread, their memory accesses overlap
+static const size_t search_group_size = 16;
+
+inline void prefetch(const void* address)
+{
+#ifdef __GNUC__
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+// Branchless lower bound, size > 0
+template<typename RandomAccessIterator, typename T, typename Compare>
+inline size_t lower_bound_index(RandomAccessIterator first, size_t size, const T& value, Compare& cmp)
+{
+    size_t base = 0;
+    while (size > 1) {
+        const size_t half = size / 2;
+        base = cmp(first[base + half], value) ? base + half : base;
+        size -= half;
+    }
+    return base + cmp(first[base], value);
+}
+
+/**
+ *  @brief Positions of lower bounds of @p count queries in [first, first + size), size > 0.
+ *
+ *  Search_group_size searches go level by level together. When a search
+ *  steps down, the element of its next step is prefetched, so it is loaded
+ *  while the other searches of the group step down.
+*/
+template<typename RandomAccessIterator, typename QueryIt, typename OutputIt, typename Compare>
+inline void lower_bound_interleaved(RandomAccessIterator first, size_t size, QueryIt queries, size_t count, OutputIt out, Compare& cmp)
+{
+    if (size == 0) {
+        std::fill(out, out + count, 0);
+        return;
+    }
+    size_t i = 0;
+    for (; i + search_group_size <= count; i += search_group_size) {
+        size_t bases[search_group_size] = {};
+        for (size_t rest = size; rest > 1;) {
+            const size_t half = rest / 2;
+            rest -= half;
+            for (size_t g = 0; g < search_group_size; g++) {
+                bases[g] = cmp(first[bases[g] + half], queries[i + g]) ? bases[g] + half : bases[g];
+                detail::prefetch(&first[bases[g] + rest / 2]);
+            }
+        }
+        for (size_t g = 0; g < search_group_size; g++) {
+            out[i + g] = bases[g] + cmp(first[bases[g]], queries[i + g]);
+        }
+    }
+    for (; i < count; i++) {
+        out[i] = detail::lower_bound_index(first, size, queries[i], cmp);
+    }
+}
+
+}
+
+/**
+ *  @brief Find lower bounds of many values in a sorted sequence.
+ *  @param  begin          A random access iterator of the sorted sequence.
+ *  @param  end            A random access iterator.
+ *  @param  queries_begin  A random access iterator of values to search for.
+ *  @param  queries_end    A random access iterator.
+ *  @param  d_first        A random access iterator, the beginning of the destination.
+ *  @param  cmp            A comparison functor.
+ *  @param  pool           Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Stores std::lower_bound(begin, end, q, cmp) - begin for every query @e q
+ *  into the respective position of the destination. Parts of queries are
+ *  processed by different threads, every thread runs several branchless
+ *  searches at once to hide memory latency. If queries of a part are
+ *  sorted, the part is searched only between bounds of its first and last
+ *  queries, @p cmp has to accept queries as both arguments then.
+*/
+template<typename RandomAccessIterator, typename QueryIt, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt lower_bound_batch(RandomAccessIterator begin, RandomAccessIterator end, QueryIt queries_begin, QueryIt queries_end,
+                                            OutputIt d_first, Compare cmp, mt::thread_pool& pool)
+{
+    const size_t size = std::distance(begin, end);
+    const size_t count = std::distance(queries_begin, queries_end);
+    mt::parallel_for(0, count, [=, &cmp](size_t from, size_t to) {
+        if (size == 0) {
+            std::fill(d_first + from, d_first + to, 0);
+            return;
+        }
+        size_t low = 0, high = size;
+        if (std::is_sorted(queries_begin + from, queries_begin + to, cmp)) {
+            low = detail::lower_bound_index(begin, size, queries_begin[from], cmp);
+            high = std::min(size, detail::lower_bound_index(begin, size, queries_begin[to - 1], cmp) + 1);
+        }
+        if (low == high) {
+            // all queries are greater than the last element
+            std::fill(d_first + from, d_first + to, low);
+            return;
+        }
+        detail::lower_bound_interleaved(begin + low, high - low, queries_begin + from, to - from, d_first + from, cmp);
+        if (low != 0) {
+            for (size_t i = from; i < to; i++) d_first[i] += low;
+        }
+    }, pool, detail::search_group_size * 16);
+    return d_first + count;
+}
+
+template<typename RandomAccessIterator, typename QueryIt, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt lower_bound_batch(RandomAccessIterator begin, RandomAccessIterator end, QueryIt queries_begin, QueryIt queries_end,
+                                            OutputIt d_first, Compare cmp)
+{
+    return mt::lower_bound_batch(begin, end, queries_begin, queries_end, d_first, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename QueryIt, typename OutputIt>
+CONSTEXPR inline OutputIt lower_bound_batch(RandomAccessIterator begin, RandomAccessIterator end, QueryIt queries_begin, QueryIt queries_end,
+                                            OutputIt d_first, mt::thread_pool& pool)
+{
+    return mt::lower_bound_batch(begin, end, queries_begin, queries_end, d_first,
+                                 std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator, typename QueryIt, typename OutputIt>
+CONSTEXPR inline OutputIt lower_bound_batch(RandomAccessIterator begin, RandomAccessIterator end, QueryIt queries_begin, QueryIt queries_end,
+                                            OutputIt d_first)
+{
+    return mt::lower_bound_batch(begin, end, queries_begin, queries_end, d_first, mt::default_pool());
+}
+
+/**
+ *  @brief Copy of a sorted sequence in Eytzinger (BFS) layout for faster searches.
+ *
+ *  The k-th element has children 2k and 2k+1, so the first levels of all
+ *  searches share cache lines, and the elements of several next levels of
+ *  a search lie in one cache line, which is prefetched. It is built once by
+ *  several threads and answers lower bound queries with positions in the
+ *  original sorted sequence.
+*/
+template<typename T, typename Compare = std::less<T>>
+class eytzinger_index {
+public:
+    template<typename RandomAccessIterator>
+    eytzinger_index(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool = mt::default_pool(), Compare cmp = Compare())
+        : cmp(cmp), keys(std::distance(begin, end) + 1), positions(keys.size()) {
+        mt::task_group group(pool);
+        size_t parallel_depth = 2;
+        for (size_t threads = pool.size(); threads > 1; threads /= 2) parallel_depth++;
+        group.run([this, &group, begin, parallel_depth]{ build(group, begin, 1, 0, parallel_depth); });
+        group.wait();
+    }
+
+    size_t size() const {
+        return keys.size() - 1;
+    }
+
+    // The same as std::lower_bound(begin, end, value, cmp) - begin for the original sequence
+    size_t lower_bound(const T& value) const {
+        const size_t n = size();
+        const size_t prefetch_distance = std::max<size_t>(detail::cache_line_size / sizeof(T), 1);
+        size_t k = 1;
+        while (k <= n) {
+            detail::prefetch(keys.data() + std::min(k * prefetch_distance, n));
+            k = 2 * k + cmp(keys[k], value);
+        }
+        // the last step to the left leads to the lower bound
+        k >>= __builtin_ffsll(~k);
+        return k == 0 ? n : positions[k];
+    }
+
+    /**
+     *  @brief Find lower bounds of many values.
+     *  @param  queries_begin  A random access iterator of values to search for.
+     *  @param  queries_end    A random access iterator.
+     *  @param  d_first        A random access iterator, the beginning of the destination.
+     *  @param  pool           Thread pool which will be used for processing.
+     *  @return  An iterator designating the end of the resulting sequence.
+    */
+    template<typename QueryIt, typename OutputIt>
+    OutputIt lower_bound_batch(QueryIt queries_begin, QueryIt queries_end, OutputIt d_first, mt::thread_pool& pool = mt::default_pool()) const {
+        const size_t count = std::distance(queries_begin, queries_end);
+        mt::parallel_for(0, count, [this, queries_begin, d_first](size_t from, size_t to) {
+            for (size_t i = from; i < to; i++) d_first[i] = lower_bound(queries_begin[i]);
+        }, pool, detail::search_group_size * 16);
+        return d_first + count;
+    }
+
+private:
+    // Amount of nodes of the subtree of the k-th node
+    size_t subtree_size(size_t k) const {
+        const size_t n = size();
+        size_t result = 0;
+        for (size_t level = 1; k <= n; level *= 2, k *= 2) {
+            result += std::min(n, k + level - 1) - k + 1;
+        }
+        return result;
+    }
+
+    // Fills the subtree of the k-th node by in-order traversal, offset is the position of its first element
+    template<typename RandomAccessIterator>
+    void build(mt::task_group& group, RandomAccessIterator begin, size_t k, size_t offset, size_t parallel_depth) {
+        if (k > size()) return;
+        const size_t left = subtree_size(2 * k);
+        keys[k] = begin[offset + left];
+        positions[k] = offset + left;
+        if (parallel_depth != 0) {
+            group.run([this, &group, begin, k, offset, parallel_depth]{ build(group, begin, 2 * k, offset, parallel_depth - 1); });
+        } else {
+            build(group, begin, 2 * k, offset, 0);
+        }
+        build(group, begin, 2 * k + 1, offset + left + 1, parallel_depth ? parallel_depth - 1 : 0);
+    }
+
+    Compare cmp;
+    std::vector<T> keys;          // keys[0] is not used
+    std::vector<size_t> positions;
+};
+
+}
+
+#endif // MT_SEARCH_HPP
@@ -0,0 +1,314 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/** @file mt/set_operations.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_SET_OPERATIONS_HPP
+#define MT_SET_OPERATIONS_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include "merge.hpp"
+#include <algorithm>    // for std::set_union, std::set_intersection, std::set_difference, std::lower_bound
+#include <functional>   // for std::less
+#include <iterator>     // for std::iterator_traits, std::output_iterator_tag
+#include <utility>      // for std::pair
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Output iterator which only counts elements written to it
+struct counting_iterator {
+    typedef std::output_iterator_tag iterator_category;
+    typedef void value_type;
+    typedef void difference_type;
+    typedef void pointer;
+    typedef void reference;
+
+    template<typename T>
+    counting_iterator& operator=(const T&) { return *this; }
+    counting_iterator& operator*() { return *this; }
+    counting_iterator& operator++() { count++; return *this; }
+    counting_iterator operator++(int) { counting_iterator it = *this; count++; return it; }
+
+    size_t count = 0;
+};
+
+/**
+ *  @brief Split two sorted ranges into parts for set operations.
+ *  @return  @p parts_amount + 1 pairs of offsets of both ranges, parts are
+ *  between consecutive pairs.
+ *
+ *  A part starts at a position of the merge of the ranges found by
+ *  co_rank(), then the start is moved back to the first element of both
+ *  ranges which is equal to the element at this position. So all equal
+ *  elements of both ranges are in the same part, and set operations of
+ *  parts give the set operation of the ranges, duplicates included.
+*/
+template<typename It1, typename It2, typename Compare>
+inline std::vector<std::pair<size_t, size_t>> set_bounds(It1 a, size_t a_size, It2 b, size_t b_size, Compare& cmp, size_t parts_amount)
+{
+    const size_t size = a_size + b_size;
+    std::vector<std::pair<size_t, size_t>> bounds(parts_amount + 1);
+    bounds[parts_amount] = std::make_pair(a_size, b_size);
+    for (size_t part = 1; part < parts_amount; part++) {
+        const size_t k = size * part / parts_amount;
+        const size_t i = detail::co_rank(k, a, a_size, b, b_size, cmp);
+        const size_t j = k - i;
+        // the k-th element of the merge, ties are taken from a
+        if (i < a_size && (j == b_size || !cmp(b[j], a[i]))) {
+            bounds[part] = std::make_pair(size_t(std::lower_bound(a, a + i, a[i], cmp) - a),
+                                          size_t(std::lower_bound(b, b + j, a[i], cmp) - b));
+        } else {
+            bounds[part] = std::make_pair(size_t(std::lower_bound(a, a + i, b[j], cmp) - a),
+                                          size_t(std::lower_bound(b, b + j, b[j], cmp) - b));
+        }
+    }
+    return bounds;
+}
+
+/**
+ *  @brief Apply a set operation to two sorted ranges by several tasks.
+ *  @param  op  Functor which calls the serial operation, e.g. std::set_union(), for parts of the ranges.
+ *
+ *  Parts are found by set_bounds(). The output of every part is counted in
+ *  parallel first, exclusive prefix sums of the counts give the offsets of
+ *  parts in the destination, so every part is written to its place by its
+ *  own task.
+*/
+template<typename It1, typename It2, typename OutputIt, typename Compare, typename Operation>
+inline OutputIt parallel_set_operation(It1 a, size_t a_size, It2 b, size_t b_size, OutputIt out, Compare& cmp, Operation op,
+                                       mt::thread_pool& pool)
+{
+    const size_t size = a_size + b_size;
+    const size_t parts_amount = detail::parts_amount(size, pool, merge_min_block_size);
+    if (parts_amount == 1) return op(a, a + a_size, b, b + b_size, out, cmp);
+
+    const std::vector<std::pair<size_t, size_t>> bounds = detail::set_bounds(a, a_size, b, b_size, cmp, parts_amount);
+    std::vector<size_t> offsets(parts_amount + 1);
+    mt::task_group group(pool);
+    for (size_t part = 0; part < parts_amount; part++) {
+        const std::pair<size_t, size_t> from = bounds[part], to = bounds[part + 1];
+        size_t& count = offsets[part + 1];
+        group.run_at(detail::home_worker(pool, from.first + from.second, size), [a, b, from, to, &count, &cmp, &op]{
+            count = op(a + from.first, a + to.first, b + from.second, b + to.second, counting_iterator(), cmp).count;
+        });
+    }
+    group.wait();
+
+    for (size_t part = 0; part < parts_amount; part++) {
+        offsets[part + 1] += offsets[part];
+    }
+    for (size_t part = 0; part < parts_amount; part++) {
+        const std::pair<size_t, size_t> from = bounds[part], to = bounds[part + 1];
+        const OutputIt _out = out + offsets[part];
+        group.run_at(detail::home_worker(pool, from.first + from.second, size), [a, b, from, to, _out, &cmp, &op]{
+            op(a + from.first, a + to.first, b + from.second, b + to.second, _out, cmp);
+        });
+    }
+    group.wait();
+    return out + offsets[parts_amount];
+}
+
+struct set_union_operation {
+    template<typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare& cmp) const {
+        return std::set_union(first1, last1, first2, last2, out, cmp);
+    }
+};
+
+struct set_intersection_operation {
+    template<typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare& cmp) const {
+        return std::set_intersection(first1, last1, first2, last2, out, cmp);
+    }
+};
+
+struct set_difference_operation {
+    template<typename It1, typename It2, typename OutputIt, typename Compare>
+    OutputIt operator()(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out, Compare& cmp) const {
+        return std::set_difference(first1, last1, first2, last2, out, cmp);
+    }
+};
+
+}
+
+/**
+ *  @brief Compute the union of two sorted sequences.
+ *  @param  first1   A random access iterator of the first sequence.
+ *  @param  last1    A random access iterator.
+ *  @param  first2   A random access iterator of the second sequence.
+ *  @param  last2    A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  cmp      A comparison functor.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as std::set_union(). Both sequences are split into parts at
+ *  the same values, so every part is processed by its own task. Parts
+ *  count their output first, so they are written to their offsets of the
+ *  destination in parallel.
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt set_union(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                    OutputIt d_first, Compare cmp, mt::thread_pool& pool)
+{
+    return detail::parallel_set_operation(first1, std::distance(first1, last1), first2, std::distance(first2, last2), d_first, cmp,
+                                          detail::set_union_operation(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt set_union(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                    OutputIt d_first, Compare cmp)
+{
+    return mt::set_union(first1, last1, first2, last2, d_first, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt set_union(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                    OutputIt d_first, mt::thread_pool& pool)
+{
+    return mt::set_union(first1, last1, first2, last2, d_first, std::less<typename std::iterator_traits<RandomAccessIterator1>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt set_union(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                    OutputIt d_first)
+{
+    return mt::set_union(first1, last1, first2, last2, d_first, mt::default_pool());
+}
+
+/**
+ *  @brief Compute the intersection of two sorted sequences.
+ *  @param  first1   A random access iterator of the first sequence.
+ *  @param  last1    A random access iterator.
+ *  @param  first2   A random access iterator of the second sequence.
+ *  @param  last2    A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  cmp      A comparison functor.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as std::set_intersection(), elements are copied from the first
+ *  sequence. It is parallelized as mt::set_union().
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt set_intersection(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                           OutputIt d_first, Compare cmp, mt::thread_pool& pool)
+{
+    return detail::parallel_set_operation(first1, std::distance(first1, last1), first2, std::distance(first2, last2), d_first, cmp,
+                                          detail::set_intersection_operation(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt set_intersection(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                           OutputIt d_first, Compare cmp)
+{
+    return mt::set_intersection(first1, last1, first2, last2, d_first, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt set_intersection(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                           OutputIt d_first, mt::thread_pool& pool)
+{
+    return mt::set_intersection(first1, last1, first2, last2, d_first, std::less<typename std::iterator_traits<RandomAccessIterator1>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt set_intersection(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                           OutputIt d_first)
+{
+    return mt::set_intersection(first1, last1, first2, last2, d_first, mt::default_pool());
+}
+
+/**
+ *  @brief Compute the difference of two sorted sequences.
+ *  @param  first1   A random access iterator of the first sequence.
+ *  @param  last1    A random access iterator.
+ *  @param  first2   A random access iterator of the second sequence.
+ *  @param  last2    A random access iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  cmp      A comparison functor.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as std::set_difference(), elements of the first sequence which
+ *  are not found in the second one are copied. It is parallelized as
+ *  mt::set_union().
+*/
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt set_difference(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                         OutputIt d_first, Compare cmp, mt::thread_pool& pool)
+{
+    return detail::parallel_set_operation(first1, std::distance(first1, last1), first2, std::distance(first2, last2), d_first, cmp,
+                                          detail::set_difference_operation(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt, typename Compare>
+CONSTEXPR inline OutputIt set_difference(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                         OutputIt d_first, Compare cmp)
+{
+    return mt::set_difference(first1, last1, first2, last2, d_first, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt set_difference(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                         OutputIt d_first, mt::thread_pool& pool)
+{
+    return mt::set_difference(first1, last1, first2, last2, d_first, std::less<typename std::iterator_traits<RandomAccessIterator1>::value_type>(), pool);
+}
+
+template<typename RandomAccessIterator1, typename RandomAccessIterator2, typename OutputIt>
+CONSTEXPR inline OutputIt set_difference(RandomAccessIterator1 first1, RandomAccessIterator1 last1, RandomAccessIterator2 first2, RandomAccessIterator2 last2,
+                                         OutputIt d_first)
+{
+    return mt::set_difference(first1, last1, first2, last2, d_first, mt::default_pool());
+}
+
+}
+
+#endif // MT_SET_OPERATIONS_HPP
@@ -0,0 +1,249 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/simd_unique.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_SIMD_UNIQUE_HPP
+#define MT_SIMD_UNIQUE_HPP
+
+#include <algorithm>    // for std::unique
+#include <functional>   // for std::equal_to
+#include <iterator>     // for std::iterator_traits
+#include <type_traits>  // for std::integral_constant, std::enable_if
+#include <vector>       // for std::vector
+#include <stdint.h>
+
+// Vectorized kernels are compiled for their own instruction sets and chosen at runtime,
+// so the binary doesn't need -mavx2 or -march=native. Define MT_NO_SIMD to disable them
+#if !defined(MT_NO_SIMD) && defined(__GNUC__) && defined(__x86_64__)
+#define MT_SIMD_UNIQUE 1
+#include <immintrin.h>
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Common part of all kernels: unique of [from, end) to out, if the original element before from is previous
+template<typename T>
+inline T* unique_scalar(T* out, T* from, T* end, T previous)
+{
+    for (; from != end; ++from) {
+        const T value = *from;
+        if (value != previous) *out++ = value;
+        previous = value;
+    }
+    return out;
+}
+
+#ifdef MT_SIMD_UNIQUE
+
+// Every kernel keeps the first element, compares each vector with the same one shifted by an element
+// and stores elements which differ from the previous ones. Stores never pass the elements which are still to be read.
+// Kernels take integers of their size as they are, equality doesn't depend on signedness
+
+template<typename T>
+__attribute__((target("avx512f")))
+inline typename std::enable_if<sizeof(T) == 4, T*>::type unique_avx512(T* begin, T* end)
+{
+    T* out = begin + 1;
+    T* from = begin + 1;
+    for (; end - from >= 16; from += 16) {
+        const __m512i values = _mm512_loadu_si512(from);
+        const __mmask16 keep = _mm512_cmpneq_epi32_mask(values, _mm512_loadu_si512(from - 1));
+        _mm512_mask_compressstoreu_epi32(out, keep, values);
+        out += __builtin_popcount(keep);
+    }
+    return detail::unique_scalar(out, from, end, from[-1]);
+}
+
+template<typename T>
+__attribute__((target("avx512f")))
+inline typename std::enable_if<sizeof(T) == 8, T*>::type unique_avx512(T* begin, T* end)
+{
+    T* out = begin + 1;
+    T* from = begin + 1;
+    for (; end - from >= 8; from += 8) {
+        const __m512i values = _mm512_loadu_si512(from);
+        const __mmask8 keep = _mm512_cmpneq_epi64_mask(values, _mm512_loadu_si512(from - 1));
+        _mm512_mask_compressstoreu_epi64(out, keep, values);
+        out += __builtin_popcount(keep);
+    }
+    return detail::unique_scalar(out, from, end, from[-1]);
+}
+
+// Permutations which move 32 bit lanes selected by a mask to the beginning of a AVX2 vector
+struct avx2_compress_table {
+    alignas(32) uint32_t lanes32[256][8]; // mask of 8 lanes of 32 bits
+    alignas(32) uint32_t lanes64[16][8];  // mask of 4 lanes of 64 bits, as pairs of 32 bit lanes
+
+    avx2_compress_table() {
+        for (uint32_t mask = 0; mask < 256; mask++) {
+            uint32_t kept = 0;
+            for (uint32_t lane = 0; lane < 8; lane++)
+                if (mask & (1u << lane)) lanes32[mask][kept++] = lane;
+            for (; kept < 8; kept++) lanes32[mask][kept] = 0;
+        }
+        for (uint32_t mask = 0; mask < 16; mask++) {
+            uint32_t kept = 0;
+            for (uint32_t lane = 0; lane < 4; lane++)
+                if (mask & (1u << lane)) {
+                    lanes64[mask][kept++] = 2 * lane;
+                    lanes64[mask][kept++] = 2 * lane + 1;
+                }
+            for (; kept < 8; kept++) lanes64[mask][kept] = 0;
+        }
+    }
+
+    static const avx2_compress_table& get() {
+        static const avx2_compress_table table;
+        return table;
+    }
+};
+
+// AVX2 has no compress store, so the whole vector is stored and lanes after the kept ones are garbage.
+// They may overwrite the last element of the current vector, that's why previous elements are taken from registers
+template<typename T>
+__attribute__((target("avx2")))
+inline typename std::enable_if<sizeof(T) == 4, T*>::type unique_avx2(T* begin, T* end)
+{
+    const avx2_compress_table& table = avx2_compress_table::get();
+    T* out = begin + 1;
+    T* from = begin + 1;
+    if (end - from >= 8) {
+        const __m256i rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+        __m256i previous = _mm256_set1_epi32(from[-1]);
+        for (; end - from >= 8; from += 8) {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from));
+            const __m256i shifted = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(values, rotate),
+                                                       _mm256_permutevar8x32_epi32(previous, _mm256_set1_epi32(7)), 0x01);
+            const uint32_t keep = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(values, shifted))) & 0xff;
+            const __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.lanes32[keep]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(values, lanes));
+            out += __builtin_popcount(keep);
+            previous = values;
+        }
+        return detail::unique_scalar(out, from, end, T(_mm256_extract_epi32(previous, 7)));
+    }
+    return detail::unique_scalar(out, from, end, from[-1]);
+}
+
+template<typename T>
+__attribute__((target("avx2")))
+inline typename std::enable_if<sizeof(T) == 8, T*>::type unique_avx2(T* begin, T* end)
+{
+    const avx2_compress_table& table = avx2_compress_table::get();
+    T* out = begin + 1;
+    T* from = begin + 1;
+    if (end - from >= 4) {
+        __m256i previous = _mm256_set1_epi64x(from[-1]);
+        for (; end - from >= 4; from += 4) {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(from));
+            const __m256i shifted = _mm256_blend_epi32(_mm256_permute4x64_epi64(values, _MM_SHUFFLE(2, 1, 0, 3)),
+                                                       _mm256_permute4x64_epi64(previous, _MM_SHUFFLE(3, 3, 3, 3)), 0x03);
+            const uint32_t keep = ~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(values, shifted))) & 0x0f;
+            const __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(table.lanes64[keep]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(values, lanes));
+            out += __builtin_popcount(keep);
+            previous = values;
+        }
+        return detail::unique_scalar(out, from, end, T(_mm256_extract_epi64(previous, 3)));
+    }
+    return detail::unique_scalar(out, from, end, from[-1]);
+}
+
+enum class simd_level { none, avx2, avx512 };
+
+inline simd_level cpu_simd_level()
+{
+    static const simd_level level = __builtin_cpu_supports("avx512f") ? simd_level::avx512 :
+                                    __builtin_cpu_supports("avx2") ? simd_level::avx2 : simd_level::none;
+    return level;
+}
+
+#endif // MT_SIMD_UNIQUE
+
+// The same as std::unique(begin, end) for 32 and 64 bit integers, begin != end
+template<typename T>
+inline T* simd_unique(T* begin, T* end)
+{
+#ifdef MT_SIMD_UNIQUE
+    switch (detail::cpu_simd_level()) {
+    case simd_level::avx512: return detail::unique_avx512(begin, end);
+    case simd_level::avx2: return detail::unique_avx2(begin, end);
+    case simd_level::none: break;
+    }
+#endif
+    return detail::unique_scalar(begin + 1, begin + 1, end, *begin);
+}
+
+template<typename T>
+struct is_contiguous_iterator : std::integral_constant<bool,
+    std::is_pointer<T>::value ||
+    std::is_same<T, typename std::vector<typename std::iterator_traits<T>::value_type>::iterator>::value> {};
+
+// Integers are equal if and only if their bits are, that's not true for floating point values
+template<class ForwardIt, class BinaryPredicate, typename T = typename std::iterator_traits<ForwardIt>::value_type>
+struct is_simd_unique_supported : std::integral_constant<bool,
+    is_contiguous_iterator<ForwardIt>::value && std::is_same<BinaryPredicate, std::equal_to<T>>::value &&
+    std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)> {};
+
+template<class ForwardIt, class BinaryPredicate>
+inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate p, std::false_type)
+{
+    return std::unique(begin, end, p);
+}
+
+template<class ForwardIt, class BinaryPredicate>
+inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate, std::true_type)
+{
+    if (begin == end) return end;
+    typename std::iterator_traits<ForwardIt>::value_type* first = &*begin;
+    return begin + (detail::simd_unique(first, first + (end - begin)) - first);
+}
+
+// std::unique(), but vectorized kernels are used when it is possible
+template<class ForwardIt, class BinaryPredicate>
+inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate p)
+{
+    return detail::unique(begin, end, p, is_simd_unique_supported<ForwardIt, BinaryPredicate>());
+}
+
+}
+
+}
+
+#endif // MT_SIMD_UNIQUE_HPP
@@ -40,24 +40,567 @@
 #define MT_SORT_HPP
 
 #include "thread_pool.hpp"
+#include "partition.hpp"
+#include "sample_sort.hpp"
+#include "radix_sort.hpp"
+#include "compact.hpp"
+#include "simd_unique.hpp"
+#include "merge.hpp"
+#include "parallel_for.hpp"
 #include <algorithm>        // for std::sort
+#include <atomic>           // for std::atomic
+#include <iterator>         // for std::move_iterator
+#include <mutex>            // for std::mutex
+#include <type_traits>      // for std::is_default_constructible
+#include <utility>          // for std::pair
 
 #ifndef CONSTEXPR
 #if __cplusplus >= 201703L
-#define CONSTEXPR contexpr
+#define CONSTEXPR constexpr
 #else
 #define CONSTEXPR
 #endif
 #endif
 
+// Ranges of fewer bytes are sorted by one thread, the default is a half of a typical L2 cache
+#ifndef MT_SORT_MIN_LEAF_BYTES
+#define MT_SORT_MIN_LEAF_BYTES 0x40000
+#endif
+
+// Ranges are split until there are so many tasks per thread even if no thread is idle
+#ifndef MT_SORT_TASKS_PER_THREAD
+#define MT_SORT_TASKS_PER_THREAD 8
+#endif
+
 namespace mt {
 
+/**
+ *  @brief Granularity of tasks which mt::sort() creates for quicksort.
+ *
+ *  Ranges bigger than @p size / (threads * @p tasks_per_thread) are always
+ *  split. Smaller ones are split only while some threads of the pool are
+ *  idle (lazy binary splitting), but never below @p min_leaf_bytes. Unless
+ *  @p detect_runs is false, presorted input (sorted, reversed or made of
+ *  long sorted runs) is found by a parallel scan and merged instead. If
+ *  @p cancelled is set, quicksort checks it at every partition and stops
+ *  when it is true, see mt::sort_async(). Defaults
+ *  may be changed by MT_SORT_MIN_LEAF_BYTES and MT_SORT_TASKS_PER_THREAD, or
+ *  per call, e.g.
+ *  @code
+ *  mt::sort_tuning tuning;
+ *  tuning.min_leaf_bytes = 0x100000;
+ *  mt::sort(mt::sort_policy::quick_sort(tuning), v.begin(), v.end());
+ *  @endcode
+*/
+struct sort_tuning {
+    size_t min_leaf_bytes;
+    size_t tasks_per_thread;
+    bool split_while_idle;
+    bool detect_runs;
+    const std::atomic<bool>* cancelled;
+
+    sort_tuning() : min_leaf_bytes(MT_SORT_MIN_LEAF_BYTES), tasks_per_thread(MT_SORT_TASKS_PER_THREAD), split_while_idle(true), detect_runs(true),
+                    cancelled(nullptr) {}
+};
+
+/**
+ *  Algorithms which may be chosen by the first argument of mt::sort().
+*/
+namespace sort_policy {
+
+// Recursive quicksort, both parts of every partition are sorted by separate tasks (default)
+struct quick_sort {
+    mt::sort_tuning tuning;
+
+    quick_sort() {}
+    explicit quick_sort(const mt::sort_tuning& tuning) : tuning(tuning) {}
+};
+
+// Samplesort, see mt::detail::sample_sort()
+struct sample_sort {};
+
+// LSD radix sort, see mt::radix_sort(). Requires arithmetic values and std::less or std::greater
+struct radix_sort {};
+
+}
+
+namespace detail {
+
+template<typename Policy>
+struct is_sort_policy : std::integral_constant<bool,
+    std::is_same<Policy, sort_policy::quick_sort>::value ||
+    std::is_same<Policy, sort_policy::sample_sort>::value ||
+    std::is_same<Policy, sort_policy::radix_sort>::value> {};
+
+inline size_t log2(size_t value)
+{
+    size_t result = 0;
+    while (value >>= 1) ++result;
+    return result;
+}
+
+template<typename RandomAccessIterator, typename Compare>
+inline RandomAccessIterator median_of_three(RandomAccessIterator a, RandomAccessIterator b, RandomAccessIterator c, Compare& cmp)
+{
+    if (cmp(*a, *b))
+        return cmp(*b, *c) ? b : (cmp(*a, *c) ? c : a);
+    return cmp(*a, *c) ? a : (cmp(*b, *c) ? c : b);
+}
+
+// Tukey's ninther: the median of three medians of three samples spread over the whole range
+template<typename RandomAccessIterator, typename Compare>
+inline RandomAccessIterator choose_pivot(RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp)
+{
+    const size_t sz = end - begin;
+    const RandomAccessIterator middle = begin + sz / 2, last = end - 1;
+    if (sz < 128)
+        return detail::median_of_three(begin, middle, last, cmp);
+
+    const size_t step = sz / 8;
+    return detail::median_of_three(detail::median_of_three(begin, begin + step, begin + 2 * step, cmp),
+                                   detail::median_of_three(middle - step, middle, middle + step, cmp),
+                                   detail::median_of_three(last - 2 * step, last - step, last, cmp), cmp);
+}
+
+// Single pass three-way partition (Bentley-McIlroy variant of the Dutch national flag problem):
+// [begin, first) < pivot, [first, second) == pivot, [second, end) > pivot.
+// Hoare-like scan swaps only misplaced elements, equal ones are gathered at both ends, then moved to the middle
+template<typename RandomAccessIterator, typename T, typename Compare>
+inline std::pair<RandomAccessIterator, RandomAccessIterator> partition3(RandomAccessIterator begin, RandomAccessIterator end, const T& pivot, Compare& cmp)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::difference_type difference_type;
+    difference_type left_equal = 0, left = 0, right = end - begin - 1, right_equal = right;
+    for (;;) {
+        for (; left <= right && !cmp(pivot, begin[left]); ++left)
+            if (!cmp(begin[left], pivot)) std::iter_swap(begin + left_equal++, begin + left);
+        for (; left <= right && !cmp(begin[right], pivot); --right)
+            if (!cmp(pivot, begin[right])) std::iter_swap(begin + right, begin + right_equal--);
+        if (left > right) break;
+        std::iter_swap(begin + left++, begin + right--);
+    }
+
+    const difference_type less = left - left_equal, greater = right_equal - right;
+    std::swap_ranges(begin, begin + std::min(left_equal, less), begin + left - std::min(left_equal, less));
+    std::swap_ranges(begin + left, begin + left + std::min(greater, end - begin - 1 - right_equal),
+                     end - std::min(greater, end - begin - 1 - right_equal));
+    return std::make_pair(begin + less, end - greater);
+}
+
+// Predicate which is true for equal neighbours of a sequence sorted by Compare
+template<typename Compare>
+struct sorted_equal {
+    Compare& cmp;
+
+    template<typename T>
+    bool operator()(const T& a, const T& b) const { return !cmp(a, b); }
+};
+
+template<typename Compare>
+inline sorted_equal<Compare> sorted_equal_to(Compare& cmp)
+{
+    return {cmp};
+}
+
+// std::equal_to allows vectorized kernels of detail::unique()
+template<typename T>
+inline std::equal_to<T> sorted_equal_to(std::less<T>&)
+{
+    return std::equal_to<T>();
+}
+
+template<typename T>
+inline std::equal_to<T> sorted_equal_to(std::greater<T>&)
+{
+    return std::equal_to<T>();
+}
+
+// Ranges which are left after dropping duplicates from sorted parts of a sequence, in any order
+template<typename RandomAccessIterator>
+struct kept_ranges {
+    RandomAccessIterator first;
+    std::mutex mutex;
+    std::vector<compact_range> ranges;
+
+    void add(RandomAccessIterator begin, RandomAccessIterator end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ranges.push_back({size_t(begin - first), size_t(end - first)});
+    }
+};
+
+template<typename RandomAccessIterator, typename Compare>
+struct quick_sort {
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+
+    mt::task_group& group;
+    Compare& cmp;
+    size_t min_leaf_size;  // ranges which are not bigger are never split
+    size_t chunk_size;     // ranges which are bigger are always split
+    size_t parallel_size;  // ranges which are not smaller are partitioned by several threads
+    bool split_while_idle; // ranges between min_leaf_size and chunk_size are split while the pool has idle threads
+    kept_ranges<RandomAccessIterator>* kept; // if it is set, only the first of equal elements is kept in every sorted range
+    const std::atomic<bool>* cancelled;    // if it is set and true, ranges are left as they are
+    RandomAccessIterator first;            // the whole sequence, parts prefer workers which own their pages
+    size_t size;
+
+    void operator()(RandomAccessIterator begin, RandomAccessIterator end) const {
+        if (cancelled && cancelled->load(std::memory_order_relaxed)) return;
+        const size_t sz = end - begin;
+        if (sz <= 1) {
+            if (kept && sz == 1) kept->add(begin, end);
+            return;
+        }
+
+        if (all_equal(begin, end)) {
+            if (kept) kept->add(begin, begin + 1);
+            return;
+        }
+
+        if (split(sz)) {
+            const value_type pivot = *detail::choose_pivot(begin, end, cmp);
+            std::pair<RandomAccessIterator, RandomAccessIterator> equal;
+            if (sz / parallel_size >= 2) {
+                equal.first = detail::parallel_partition(begin, end,
+                             [this, &pivot](const value_type& em){ return cmp(em, pivot); }, group.get_pool(), sz / parallel_size);
+                equal.second = detail::parallel_partition(equal.first, end,
+                             [this, &pivot](const value_type& em){ return !cmp(pivot, em); }, group.get_pool(), (end - equal.first) / parallel_size);
+            } else {
+                equal = detail::partition3(begin, end, pivot, cmp);
+            }
+            // elements equal to the pivot are already in their final place
+            if (kept) kept->add(equal.first, equal.first + 1);
+            group.run_at(home_worker(begin), [this, begin, equal]{ (*this)(begin, equal.first); });
+            group.run_at(home_worker(equal.second), [this, equal, end]{ (*this)(equal.second, end); });
+        } else {
+            sort_chunk(begin, end, 2 * detail::log2(sz));
+            // the leaf is still in cache
+            if (kept) kept->add(begin, detail::unique(begin, end, detail::sorted_equal_to(cmp)));
+        }
+    }
+
+    size_t home_worker(RandomAccessIterator begin) const {
+        return detail::home_worker(group.get_pool(), begin - first, size);
+    }
+
+    bool split(size_t sz) const {
+        if (sz <= min_leaf_size) return false;
+        if (sz > chunk_size) return true;
+        return split_while_idle && group.get_pool().idle_amount() != 0;
+    }
+
+    // Serial quicksort with the same fat pivot, so runs of duplicates are dropped early.
+    // Falls back to std::sort for small ranges, when there are few duplicates and when the recursion is too deep
+    void sort_chunk(RandomAccessIterator begin, RandomAccessIterator end, size_t depth_limit) const {
+        while (end - begin > 32 && depth_limit-- != 0) {
+            if (all_equal(begin, end)) return;
+            const value_type pivot = *detail::choose_pivot(begin, end, cmp);
+            const std::pair<RandomAccessIterator, RandomAccessIterator> equal = detail::partition3(begin, end, pivot, cmp);
+            if ((equal.second - equal.first) * 64 < end - begin) {
+                // hardly any duplicates, std::sort is faster for the rest
+                std::sort(begin, equal.first, cmp);
+                std::sort(equal.second, end, cmp);
+                return;
+            }
+            if (equal.first - begin < end - equal.second) {
+                sort_chunk(begin, equal.first, depth_limit);
+                begin = equal.second;
+            } else {
+                sort_chunk(equal.second, end, depth_limit);
+                end = equal.first;
+            }
+        }
+        std::sort(begin, end, cmp);
+    }
+
+    // Duplicate-heavy data leaves ranges of equal elements, which cost nothing to skip.
+    // The whole range is checked only when samples from it are equal
+    bool all_equal(RandomAccessIterator begin, RandomAccessIterator end) const {
+        const RandomAccessIterator last = end - 1;
+        if (cmp(*begin, *last) || cmp(*last, *begin)) return false;
+        const RandomAccessIterator middle = begin + (end - begin) / 2;
+        if (cmp(*begin, *middle) || cmp(*middle, *begin)) return false;
+        return std::adjacent_find(begin, end, [this](const value_type& a, const value_type& b) {
+            return cmp(a, b) || cmp(b, a);
+        }) == end;
+    }
+};
+
+template<typename RandomAccessIterator, typename Compare>
+inline void quick_sort_run(const sort_policy::quick_sort& policy, RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp,
+                           mt::thread_pool& pool, kept_ranges<RandomAccessIterator>* kept)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    const size_t size = std::distance(begin, end);
+    const size_t min_leaf_size = std::max<size_t>(policy.tuning.min_leaf_bytes / sizeof(value_type), 1);
+    const size_t chunk_size = std::max(size / (pool.size() * std::max<size_t>(policy.tuning.tasks_per_thread, 1)), min_leaf_size);
+    mt::task_group group(pool);
+    detail::quick_sort<RandomAccessIterator, Compare> quick_sort {group, cmp, min_leaf_size, chunk_size,
+                                                                  std::max(size / pool.size(), detail::partition_min_block_size),
+                                                                  policy.tuning.split_while_idle, kept, policy.tuning.cancelled, begin, size};
+
+    group.run([&quick_sort, begin, end]{ quick_sort(begin, end); });
+    group.wait(); // quick_sort must outlive all tasks
+}
+
+// Parts of the scan for presorted input stop after so many runs once an ascent is seen
+static const size_t runs_max_per_part = 64;
+
+// A natural run, which is either non-descending or non-ascending; the sort isn't stable, so ties don't end descending runs
+struct scanned_run {
+    size_t begin;
+    bool descending;
+};
+
+struct runs_scan_part {
+    std::vector<scanned_run> runs;  // the first one starts at the beginning of the part
+    bool non_ascending;             // no element is less than the previous one
+    bool dense;                     // too many runs, the part is considered unsorted
+};
+
+// Runs are [begin, next begin), descending ones are reversed and unsorted ones are sorted before the merge
+struct presorted_run {
+    size_t begin;
+    bool sorted;
+    bool descending;
+};
+
+// Splits the sequence into natural runs and unsorted parts, short runs are considered unsorted
+inline std::vector<presorted_run> presorted_runs(const detail::padded_vector<runs_scan_part>& parts, size_t pairs, size_t size, size_t min_run_size)
+{
+    std::vector<presorted_run> runs;
+    auto cut = [&runs](size_t at, bool sorted, bool descending) {
+        if (!runs.empty() && runs.back().begin == at) runs.pop_back();
+        if (runs.empty() || sorted || runs.back().sorted) runs.push_back(presorted_run{at, sorted, descending});
+    };
+    cut(0, true, false);
+    for (size_t part = 0; part < parts.size(); part++) {
+        const runs_scan_part& scan = parts[part].value;
+        const size_t from = pairs * part / parts.size();
+        if (scan.dense) {
+            cut(from, false, false);
+            cut(pairs * (part + 1) / parts.size(), true, false);
+            continue;
+        }
+        for (const scanned_run& run: scan.runs) {
+            // the last run of the previous part ends with the first element of this one, so a run in the same direction goes on
+            const presorted_run& last = runs.back();
+            if (run.begin == from && last.begin != from && last.sorted && last.descending == run.descending) continue;
+            cut(run.begin, true, run.descending);
+        }
+    }
+    std::vector<presorted_run> result;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const size_t end = i + 1 < runs.size() ? runs[i + 1].begin : size;
+        if (end == runs[i].begin) continue;
+        const bool sorted = runs[i].sorted && end - runs[i].begin >= min_run_size;
+        if (!result.empty() && !result.back().sorted && !sorted) continue;
+        result.push_back(presorted_run{runs[i].begin, sorted, sorted && runs[i].descending});
+    }
+    return result;
+}
+
+template<typename RandomAccessIterator>
+inline void parallel_reverse(RandomAccessIterator begin, size_t size, mt::thread_pool& pool)
+{
+    mt::parallel_for(0, size / 2, [begin, size](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) std::iter_swap(begin + i, begin + (size - 1 - i));
+    }, pool);
+}
+
+template<typename RandomAccessIterator, typename Compare>
+inline bool merge_presorted_runs(RandomAccessIterator begin, const std::vector<presorted_run>& runs, size_t size, Compare& cmp,
+                                 mt::thread_pool& pool, std::true_type)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    typedef std::move_iterator<RandomAccessIterator> move_iterator;
+    std::vector<std::pair<move_iterator, move_iterator>> ranges;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const size_t end = i + 1 < runs.size() ? runs[i + 1].begin : size;
+        ranges.push_back(std::make_pair(std::make_move_iterator(begin + runs[i].begin), std::make_move_iterator(begin + end)));
+    }
+    scratch_buffer<value_type> buffer(pool.scratch(), size);
+    mt::merge_k(ranges.begin(), ranges.end(), buffer.begin(), cmp, pool);
+    mt::parallel_for(0, size, [begin, &buffer](size_t from, size_t to) {
+        std::move(buffer.begin() + from, buffer.begin() + to, begin + from);
+    }, pool);
+    return true;
+}
+
+// Values which can't be kept in a buffer are sorted as usual
+template<typename RandomAccessIterator, typename Compare>
+inline bool merge_presorted_runs(RandomAccessIterator, const std::vector<presorted_run>&, size_t, Compare&, mt::thread_pool&, std::false_type)
+{
+    return false;
+}
+
+/**
+ *  @brief Sort presorted input without partitioning.
+ *  @return  false if the input is not presorted, it is unchanged then.
+ *
+ *  Parts of the sequence are scanned in parallel for natural ascending and
+ *  descending runs, a part stops early when it has both too many
+ *  runs and an ascent, so unsorted input costs little. Sorted input is left
+ *  as is, non-ascending input is reversed, otherwise natural runs are merged
+ *  if they cover at least a half of the sequence; descending runs are
+ *  reversed and unsorted parts between runs are sorted first.
+*/
+template<typename RandomAccessIterator, typename Compare>
+inline bool sort_presorted(const sort_policy::quick_sort& policy, RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp,
+                           mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    const size_t size = std::distance(begin, end);
+    if (size < 2 * partition_min_block_size) return false;
+
+    // i-th pair is (begin[i], begin[i + 1])
+    const size_t pairs = size - 1;
+    const size_t parts_amount = std::max<size_t>(1, std::min(pool.size() * 4, pairs / partition_min_block_size));
+    detail::padded_vector<runs_scan_part> parts(parts_amount, detail::padded<runs_scan_part>(runs_scan_part{{}, true, false}));
+    detail::for_each_part(pairs, parts_amount, [begin, &cmp, &parts](size_t part, size_t from, size_t to) {
+        runs_scan_part& scan = parts[part].value;
+        scan.runs.push_back(scanned_run{from, false});
+        bool run_start = true; // the next unequal pair gives the direction of the last run
+        for (size_t i = from; i < to; i++) {
+            const bool descent = cmp(begin[i + 1], begin[i]);
+            // an ascent inside of an ascending run doesn't matter once the part isn't non-ascending
+            const bool ascent = !descent && (scan.non_ascending || run_start || scan.runs.back().descending) && cmp(begin[i], begin[i + 1]);
+            if (scan.non_ascending && ascent) {
+                scan.non_ascending = false;
+                if (scan.dense) return;
+            }
+            // equal elements go on a run in either direction
+            if (scan.dense || (!descent && !ascent)) continue;
+            if (run_start) {
+                scan.runs.back().descending = descent;
+                run_start = false;
+            } else if (descent != scan.runs.back().descending) {
+                if (scan.runs.size() == runs_max_per_part) {
+                    // a non-ascending part is scanned to the end, the whole sequence may be reversed
+                    scan.dense = true;
+                    if (!scan.non_ascending) return;
+                    continue;
+                }
+                scan.runs.push_back(scanned_run{i + 1, false});
+                run_start = true;
+            }
+        }
+    }, pool);
+
+    bool sorted = true, non_ascending = true;
+    for (const auto& part: parts) {
+        sorted = sorted && !part.value.dense && part.value.runs.size() == 1 && !part.value.runs[0].descending;
+        non_ascending = non_ascending && part.value.non_ascending;
+    }
+    if (sorted) return true;
+    if (non_ascending) {
+        detail::parallel_reverse(begin, size, pool);
+        return true;
+    }
+
+    const std::vector<presorted_run> runs = detail::presorted_runs(parts, pairs, size, std::max(size / 64, merge_min_block_size));
+    size_t unsorted = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        if (!runs[i].sorted) unsorted += (i + 1 < runs.size() ? runs[i + 1].begin : size) - runs[i].begin;
+    }
+    if (unsorted > size / 2) return false;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const size_t run_end = i + 1 < runs.size() ? runs[i + 1].begin : size;
+        if (runs[i].descending) {
+            detail::parallel_reverse(begin + runs[i].begin, run_end - runs[i].begin, pool);
+        } else if (!runs[i].sorted) {
+            detail::quick_sort_run(policy, begin + runs[i].begin, begin + run_end, cmp, pool,
+                                   static_cast<kept_ranges<RandomAccessIterator>*>(nullptr));
+        }
+    }
+    if (runs.size() == 1) return true;
+    if (policy.tuning.cancelled && policy.tuning.cancelled->load(std::memory_order_relaxed)) return true;
+    return detail::merge_presorted_runs(begin, runs, size, cmp, pool, std::is_default_constructible<value_type>());
+}
+
+template<typename RandomAccessIterator, typename Compare>
+inline void sort(const sort_policy::quick_sort& policy, RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool)
+{
+    if (policy.tuning.detect_runs && detail::sort_presorted(policy, begin, end, cmp, pool)) return;
+    detail::quick_sort_run(policy, begin, end, cmp, pool, static_cast<kept_ranges<RandomAccessIterator>*>(nullptr));
+}
+
+// Quicksort, where every leaf drops its duplicates while it is in cache; leaves have no common values
+// because of three-way partitioning, so it is left to move kept elements together
+template<typename RandomAccessIterator, typename Compare>
+inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool)
+{
+    kept_ranges<RandomAccessIterator> kept;
+    kept.first = begin;
+    detail::quick_sort_run(sort_policy::quick_sort(), begin, end, cmp, pool, &kept);
+    std::sort(kept.ranges.begin(), kept.ranges.end(), [](const compact_range& a, const compact_range& b) { return a.begin < b.begin; });
+    return detail::parallel_compact(begin, kept.ranges, pool);
+}
+
+template<typename RandomAccessIterator, typename Compare>
+inline void sort(sort_policy::sample_sort, RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool)
+{
+    detail::sample_sort(begin, end, cmp, pool);
+}
+
+template<typename RandomAccessIterator, typename T>
+inline void sort(sort_policy::radix_sort, RandomAccessIterator begin, RandomAccessIterator end, std::less<T>&, mt::thread_pool& pool)
+{
+    static_assert(detail::is_radix_sortable<T>::value, "sort_policy::radix_sort requires integral, float or double values");
+    detail::radix_sort(begin, end, detail::radix_key<T>(), pool);
+}
+
+template<typename RandomAccessIterator, typename T>
+inline void sort(sort_policy::radix_sort, RandomAccessIterator begin, RandomAccessIterator end, std::greater<T>&, mt::thread_pool& pool)
+{
+    static_assert(detail::is_radix_sortable<T>::value, "sort_policy::radix_sort requires integral, float or double values");
+    detail::radix_sort(begin, end, detail::reverse_radix_key<detail::radix_key<T>>(), pool);
+}
+
+}
+
+/**
+ *  @brief Sort the elements of a sequence by the chosen algorithm.
+ *  @param  policy  Algorithm, one of mt::sort_policy types.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for sorting.
+ *  @return  Nothing.
+ *
+ *  The same as mt::sort() without @p policy, e.g.
+ *  @code mt::sort(mt::sort_policy::sample_sort(), v.begin(), v.end(), pool); @endcode
+*/
+template<typename Policy, typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<detail::is_sort_policy<Policy>::value>::type>
+CONSTEXPR inline void sort(Policy policy, RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
+{
+    detail::sort(policy, begin, end, cmp, pool);
+}
+
+template<typename Policy, typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<detail::is_sort_policy<Policy>::value && !std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void sort(Policy policy, RandomAccessIterator begin, RandomAccessIterator end, Compare cmp)
+{
+    mt::sort(policy, begin, end, cmp, mt::default_pool());
+}
+
+template<typename Policy, typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>,
+         typename = typename std::enable_if<detail::is_sort_policy<Policy>::value>::type>
+CONSTEXPR inline void sort(Policy policy, RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    mt::sort(policy, begin, end, Compare(), pool);
+}
+
+template<typename Policy, typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>,
+         typename = typename std::enable_if<detail::is_sort_policy<Policy>::value>::type>
+CONSTEXPR inline void sort(Policy policy, RandomAccessIterator begin, RandomAccessIterator end)
+{
+    mt::sort(policy, begin, end, Compare(), mt::default_pool());
+}
+
 /**
  *  @brief Sort the elements of a sequence using a predicate for comparison.
  *  @param  begin           An iterator linked with first element.
  *  @param  end             Another iterator linked with last element.
  *  @param  cmp             A comparison functor.
- *  @param  threads_amount  Amount of thread which may be used for sorting.
+ *  @param  pool            Thread pool which will be used for sorting.
  *  @return  Nothing.
  *
  *  Sorts the elements in the range @p [begin,end) in ascending order,
@@ -65,33 +608,49 @@ namespace mt {
  *  range @p [begin,end-1).
  *
  *  The relative ordering of equivalent elements is not preserved, use
- *  @p stable_sort() if this is needed.
+ *  mt::stable_sort() if this is needed.
+ *
+ *  Other tasks of @p pool are not waited for, so the pool may be shared by
+ *  several sorts at once, including sorts called from tasks of the pool.
 */
 template<typename RandomAccessIterator, typename Compare/*, size_t chunk_size = 0x100000u*/>
-CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, size_t threads_amount = std::thread::hardware_concurrency())
+CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
 {
-    size_t chunk_size = std::distance(begin, end) / (threads_amount * 8);
-    mt::thread_pool pool(threads_amount);
+    mt::sort(sort_policy::quick_sort(), begin, end, cmp, pool);
+}
 
-    static const std::function<void(RandomAccessIterator, RandomAccessIterator)> quick_sort = [&chunk_size, &pool, &cmp](RandomAccessIterator begin, RandomAccessIterator end) {
-        const size_t sz = end - begin;
-        if (sz <= 1) return;
-
-        if (sz > chunk_size) {
-            // from https://en.cppreference.com/w/cpp/algorithm/partition
-            auto pivot = *std::next(begin, std::distance(begin,end)/2);
-            RandomAccessIterator middle1 = std::partition(begin, end,
-                         [pivot, &cmp](const typeof(*begin)& em){ return cmp(em, pivot); });
-            RandomAccessIterator middle2 = std::partition(middle1, end,
-                         [pivot, &cmp](const typeof(*begin)& em){ return !cmp(pivot, em); });
-            pool.push(quick_sort, begin, middle1);
-            pool.push(quick_sort, middle2, end);
-        } else {
-            std::sort(begin, end, cmp);
-        }
-    };
+/**
+ *  @brief Sort the elements of a sequence using a predicate for comparison.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @param  threads_amount  Amount of thread which may be used for sorting.
+ *  @return  Nothing.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    mt::sort(begin, end, cmp, pool);
+}
 
-    pool.push(quick_sort, begin, end);
+/**
+ *  @brief Sort the elements of a sequence using a predicate for comparison.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp)
+{
+    mt::sort(begin, end, cmp, mt::default_pool());
 }
 
 
@@ -99,7 +658,7 @@ CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end,
  *  @brief Sort the elements of a sequence.
  *  @param  begin           An iterator linked with first element.
  *  @param  end             Another iterator linked with last element.
- *  @param  threads_amount  Amount of thread which may be used for sorting.
+ *  @param  pool            Thread pool which will be used for sorting.
  *  @return  Nothing.
  *
  *  Sorts the elements in the range @p [begin,end) in ascending order,
@@ -107,14 +666,116 @@ CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end,
  *  *(i+1)<*i is false.
  *
  *  The relative ordering of equivalent elements is not preserved, use
- *  @p stable_sort() if this is needed.
+ *  mt::stable_sort() if this is needed.
 */
 template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
-CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, size_t threads_amount = std::thread::hardware_concurrency())
+CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    mt::sort(begin, end, Compare(), pool);
+}
+
+/**
+ *  @brief Sort the elements of a sequence.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  threads_amount  Amount of thread which may be used for sorting.
+ *  @return  Nothing.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end, size_t threads_amount)
 {
     mt::sort(begin, end, Compare(), threads_amount);
 }
 
+/**
+ *  @brief Sort the elements of a sequence.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    mt::sort(begin, end, Compare(), mt::default_pool());
+}
+
+/**
+ *  @brief Sort the elements of a sequence and remove equivalent ones.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @param  pool            Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as mt::sort() followed by mt::unique() with a predicate which
+ *  is true for equivalent elements, but duplicates are dropped by every
+ *  task right after its part is sorted, so the sorted sequence is not read
+ *  once more. Only kept elements are moved to their final positions.
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
+{
+    return detail::sort_unique(begin, end, cmp, pool);
+}
+
+/**
+ *  @brief Sort the elements of a sequence and remove equivalent ones.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @param  threads_amount  Amount of thread which may be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    return mt::sort_unique(begin, end, cmp, pool);
+}
+
+/**
+ *  @brief Sort the elements of a sequence and remove equivalent ones.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp)
+{
+    return mt::sort_unique(begin, end, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    return mt::sort_unique(begin, end, Compare(), pool);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end, size_t threads_amount)
+{
+    return mt::sort_unique(begin, end, Compare(), threads_amount);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline RandomAccessIterator sort_unique(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    return mt::sort_unique(begin, end, Compare(), mt::default_pool());
+}
+
 }
 
 #endif // MT_SORT_HPP
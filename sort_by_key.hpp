@@ -0,0 +1,238 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/sort_by_key.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_SORT_BY_KEY_HPP
+#define MT_SORT_BY_KEY_HPP
+
+#include "thread_pool.hpp"
+#include "parallel_for.hpp"
+#include "radix_sort.hpp"
+#include "sort.hpp"
+#include <cstdint>      // for uint32_t
+#include <functional>   // for std::less, std::greater
+#include <iterator>     // for std::iterator_traits
+#include <limits>       // for std::numeric_limits
+#include <type_traits>  // for std::decay
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+template<typename RandomAccessIterator, typename KeyFunction>
+struct key_type_of {
+    typedef typename std::decay<typename std::result_of<KeyFunction&(typename std::iterator_traits<RandomAccessIterator>::reference)>::type>::type type;
+};
+
+// Packed key of an element and its position, which is sorted instead of the element
+template<typename Key, typename Index>
+struct key_index {
+    Key key;
+    Index index;
+};
+
+template<typename ElementKey>
+struct key_index_radix_key {
+    typedef typename ElementKey::type type;
+    ElementKey key;
+    template<typename T>
+    type operator()(const T& item) const { return key(item.key); }
+};
+
+// Radix sort is used for integral, float and double keys compared by std::less or std::greater
+template<typename Key, typename Compare>
+struct use_radix_sort : std::integral_constant<bool, detail::is_radix_sortable<Key>::value &&
+    (std::is_same<Compare, std::less<Key>>::value || std::is_same<Compare, std::greater<Key>>::value)> {};
+
+// Both ways keep the order of elements with equal keys
+template<typename Item, typename Compare>
+inline void sort_key_indexes(Item* begin, Item* end, Compare& cmp, mt::thread_pool& pool, std::false_type)
+{
+    mt::sort(begin, end, [&cmp](const Item& a, const Item& b) {
+        return cmp(a.key, b.key) || (!cmp(b.key, a.key) && a.index < b.index);
+    }, pool);
+}
+
+template<typename Item, typename Key>
+inline void sort_key_indexes(Item* begin, Item* end, std::less<Key>&, mt::thread_pool& pool, std::true_type)
+{
+    detail::radix_sort(begin, end, key_index_radix_key<radix_key<Key>>(), pool);
+}
+
+template<typename Item, typename Key>
+inline void sort_key_indexes(Item* begin, Item* end, std::greater<Key>&, mt::thread_pool& pool, std::true_type)
+{
+    detail::radix_sort(begin, end, reverse_radix_key<key_index_radix_key<radix_key<Key>>>(), pool);
+}
+
+// Keys of elements with their positions in the sorted order, @p items has the size of the sequence
+template<typename Key, typename Index, typename RandomAccessIterator, typename KeyFunction, typename Compare>
+inline void sorted_key_indexes(RandomAccessIterator begin, KeyFunction& key_fn, Compare& cmp, mt::thread_pool& pool,
+                               scratch_buffer<key_index<Key, Index>>& items)
+{
+    mt::parallel_for(0, items.size(), [begin, &key_fn, &items](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) {
+            items[i].key = key_fn(begin[i]);
+            items[i].index = static_cast<Index>(i);
+        }
+    }, pool);
+    detail::sort_key_indexes(items.begin(), items.end(), cmp, pool, use_radix_sort<Key, Compare>());
+}
+
+template<typename Index, typename RandomAccessIterator, typename KeyFunction, typename Compare>
+inline void sort_by_key(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction& key_fn, Compare& cmp, mt::thread_pool& pool)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    typedef key_index<typename key_type_of<RandomAccessIterator, KeyFunction>::type, Index> item_type;
+    scratch_buffer<item_type> items(pool.scratch(), std::distance(begin, end));
+    detail::sorted_key_indexes(begin, key_fn, cmp, pool, items);
+    scratch_buffer<value_type> buffer(pool.scratch(), items.size());
+    mt::parallel_for(0, items.size(), [begin, &items, &buffer](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) buffer[i] = std::move(begin[items[i].index]);
+    }, pool);
+    mt::parallel_for(0, items.size(), [begin, &buffer](size_t from, size_t to) {
+        std::move(buffer.begin() + from, buffer.begin() + to, begin + from);
+    }, pool);
+}
+
+}
+
+/**
+ *  @brief Sort big elements of a sequence by their keys.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  key_fn  A functor which returns the key of an element, it is called once for every element.
+ *  @param  cmp     A comparison functor of keys.
+ *  @param  pool    Thread pool which will be used for sorting.
+ *  @return  Nothing.
+ *
+ *  Keys are packed with positions of elements and sorted instead of the
+ *  elements, so the sort touches only the packed keys, then every element
+ *  is moved twice: to a buffer in the sorted order and back. Arithmetic
+ *  keys compared by std::less or std::greater are sorted by mt::radix_sort(),
+ *  others by mt::sort(). The order of elements with equal keys is kept.
+ *  It is worth for elements much bigger than their keys.
+ *
+ *  @code
+ *  mt::sort_by_key(records.begin(), records.end(), [](const record& r) { return r.id; }, pool);
+ *  @endcode
+*/
+template<typename RandomAccessIterator, typename KeyFunction, typename Compare>
+CONSTEXPR inline void sort_by_key(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn, Compare cmp, mt::thread_pool& pool)
+{
+    if (size_t(std::distance(begin, end)) <= std::numeric_limits<uint32_t>::max()) {
+        detail::sort_by_key<uint32_t>(begin, end, key_fn, cmp, pool);
+    } else {
+        detail::sort_by_key<size_t>(begin, end, key_fn, cmp, pool);
+    }
+}
+
+template<typename RandomAccessIterator, typename KeyFunction, typename Compare>
+CONSTEXPR inline void sort_by_key(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn, Compare cmp)
+{
+    mt::sort_by_key(begin, end, key_fn, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename KeyFunction>
+CONSTEXPR inline void sort_by_key(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn, mt::thread_pool& pool)
+{
+    typedef typename detail::key_type_of<RandomAccessIterator, KeyFunction>::type key_type;
+    mt::sort_by_key(begin, end, key_fn, std::less<key_type>(), pool);
+}
+
+template<typename RandomAccessIterator, typename KeyFunction>
+CONSTEXPR inline void sort_by_key(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn)
+{
+    mt::sort_by_key(begin, end, key_fn, mt::default_pool());
+}
+
+/**
+ *  @brief Find the order of elements of a sequence sorted by their keys.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  key_fn  A functor which returns the key of an element, it is called once for every element.
+ *  @param  cmp     A comparison functor of keys.
+ *  @param  pool    Thread pool which will be used for sorting.
+ *  @return  Positions of the elements in the sorted order, the sequence is unchanged.
+ *
+ *  The same as mt::sort_by_key(), but elements are not moved.
+*/
+template<typename RandomAccessIterator, typename KeyFunction, typename Compare>
+CONSTEXPR inline std::vector<size_t> sort_index(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn, Compare cmp,
+                                                mt::thread_pool& pool)
+{
+    typedef detail::key_index<typename detail::key_type_of<RandomAccessIterator, KeyFunction>::type, size_t> item_type;
+    scratch_buffer<item_type> items(pool.scratch(), std::distance(begin, end));
+    detail::sorted_key_indexes(begin, key_fn, cmp, pool, items);
+    std::vector<size_t> result(items.size());
+    mt::parallel_for(0, items.size(), [&items, &result](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++) result[i] = items[i].index;
+    }, pool);
+    return result;
+}
+
+template<typename RandomAccessIterator, typename KeyFunction, typename Compare>
+CONSTEXPR inline std::vector<size_t> sort_index(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn, Compare cmp)
+{
+    return mt::sort_index(begin, end, key_fn, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename KeyFunction>
+CONSTEXPR inline std::vector<size_t> sort_index(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn, mt::thread_pool& pool)
+{
+    typedef typename detail::key_type_of<RandomAccessIterator, KeyFunction>::type key_type;
+    return mt::sort_index(begin, end, key_fn, std::less<key_type>(), pool);
+}
+
+template<typename RandomAccessIterator, typename KeyFunction>
+CONSTEXPR inline std::vector<size_t> sort_index(RandomAccessIterator begin, RandomAccessIterator end, KeyFunction key_fn)
+{
+    return mt::sort_index(begin, end, key_fn, mt::default_pool());
+}
+
+}
+
+#endif // MT_SORT_BY_KEY_HPP
@@ -0,0 +1,256 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/stable_sort.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_STABLE_SORT_HPP
+#define MT_STABLE_SORT_HPP
+
+#include "thread_pool.hpp"
+#include "merge.hpp"
+#include <algorithm>    // for std::merge, std::min
+#include <iterator>     // for std::iterator_traits
+#include <vector>       // for std::vector
+
+#ifndef CONSTEXPR
+#if __cplusplus >= 201703L
+#define CONSTEXPR constexpr
+#else
+#define CONSTEXPR
+#endif
+#endif
+
+namespace mt {
+
+namespace detail {
+
+// Runs of this size are sorted by insertion sort before merging
+static const size_t stable_sort_run_size = 32;
+
+template<typename RandomAccessIterator, typename Compare>
+inline void insertion_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp)
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    if (begin == end) return;
+    for (RandomAccessIterator i = begin + 1; i != end; ++i) {
+        value_type value = std::move(*i);
+        RandomAccessIterator j = i;
+        for (; j != begin && cmp(value, *(j - 1)); --j) {
+            *j = std::move(*(j - 1));
+        }
+        *j = std::move(value);
+    }
+}
+
+// Moves merged pairs of neighbouring runs of width elements from src to dst
+template<typename SrcIt, typename DstIt, typename Compare>
+inline void merge_pass(SrcIt src, DstIt dst, size_t size, size_t width, Compare& cmp)
+{
+    for (size_t i = 0; i < size; i += 2 * width) {
+        const size_t middle = std::min(i + width, size), to = std::min(i + 2 * width, size);
+        std::merge(std::make_move_iterator(src + i), std::make_move_iterator(src + middle),
+                   std::make_move_iterator(src + middle), std::make_move_iterator(src + to), dst + i, cmp);
+    }
+}
+
+// Serial bottom-up merge sort of a leaf, buffer has the same size as the leaf
+template<typename RandomAccessIterator, typename BufferIt, typename Compare>
+inline void stable_sort_leaf(RandomAccessIterator begin, RandomAccessIterator end, BufferIt buffer, Compare& cmp)
+{
+    const size_t size = end - begin;
+    for (size_t i = 0; i < size; i += stable_sort_run_size) {
+        detail::insertion_sort(begin + i, begin + std::min(i + stable_sort_run_size, size), cmp);
+    }
+
+    bool in_buffer = false;
+    for (size_t width = stable_sort_run_size; width < size; width *= 2) {
+        if (in_buffer) detail::merge_pass(buffer, begin, size, width, cmp);
+        else detail::merge_pass(begin, buffer, size, width, cmp);
+        in_buffer = !in_buffer;
+    }
+    if (in_buffer) std::move(buffer, buffer + size, begin);
+}
+
+// Moves merged pairs of neighbouring runs from src to dst, bounds of runs are replaced by bounds of merged ones
+template<typename SrcIt, typename DstIt, typename Compare>
+inline void merge_runs(SrcIt src, DstIt dst, std::vector<size_t>& bounds, Compare& cmp, mt::thread_pool& pool)
+{
+    const size_t size = bounds.back();
+    std::vector<size_t> merged(1, 0);
+    mt::task_group group(pool);
+    for (size_t run = 0; run + 1 < bounds.size(); run += 2) {
+        const size_t from = bounds[run], middle = bounds[run + 1];
+        const size_t to = run + 2 < bounds.size() ? bounds[run + 2] : middle; // the last run may have no pair
+        const size_t parts_amount = (to - from) * pool.size() / size + 1;
+        detail::parallel_merge(std::make_move_iterator(src + from), middle - from, std::make_move_iterator(src + middle), to - middle,
+                               dst + from, cmp, group, parts_amount);
+        merged.push_back(to);
+    }
+    group.wait();
+    bounds.swap(merged);
+}
+
+// Stable sort with a buffer of the size of the sequence
+template<typename RandomAccessIterator, typename Compare, typename BufferIt>
+inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare& cmp, mt::thread_pool& pool, BufferIt buffer)
+{
+    const size_t size = std::distance(begin, end);
+    const size_t parts_amount = std::max<size_t>(1, std::min(pool.size(), size / detail::merge_min_block_size));
+
+    std::vector<size_t> bounds(parts_amount + 1);
+    mt::task_group group(pool);
+    for (size_t i = 0; i < parts_amount; i++) {
+        const size_t from = size * i / parts_amount, to = size * (i + 1) / parts_amount;
+        bounds[i + 1] = to;
+        auto _buffer = buffer + from;
+        group.run([begin, from, to, _buffer, &cmp]{ detail::stable_sort_leaf(begin + from, begin + to, _buffer, cmp); });
+    }
+    group.wait();
+
+    bool in_buffer = false;
+    while (bounds.size() > 2) {
+        if (in_buffer) detail::merge_runs(buffer, begin, bounds, cmp, pool);
+        else detail::merge_runs(begin, buffer, bounds, cmp, pool);
+        in_buffer = !in_buffer;
+    }
+    if (in_buffer) {
+        // merge with an empty range is a parallel move
+        detail::parallel_merge(std::make_move_iterator(buffer), size, std::make_move_iterator(buffer), 0,
+                               begin, cmp, group, pool.size());
+        group.wait();
+    }
+}
+
+}
+
+/**
+ *  @brief Sort the elements of a sequence preserving the relative order of equivalent elements.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for sorting.
+ *  @param  buffer  Scratch memory, it is resized to the size of the sequence if it is smaller.
+ *  @return  Nothing.
+ *
+ *  Every thread sorts its part of the sequence by merge sort, then sorted
+ *  parts are merged pairwise. Every merge is split into independent tasks
+ *  by co-ranking (merge path), so all threads are busy until the last one.
+ *
+ *  Elements are moved between the sequence and @p buffer, so repeated calls
+ *  with the same @p buffer don't allocate memory. Contents of @p buffer are
+ *  unspecified after the call.
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool,
+                                  std::vector<typename std::iterator_traits<RandomAccessIterator>::value_type>& buffer)
+{
+    const size_t size = std::distance(begin, end);
+    if (buffer.size() < size) buffer.resize(size);
+    detail::stable_sort(begin, end, cmp, pool, buffer.begin());
+}
+
+/**
+ *  @brief Sort the elements of a sequence preserving the relative order of equivalent elements.
+ *  @param  begin   An iterator linked with first element.
+ *  @param  end     Another iterator linked with last element.
+ *  @param  cmp     A comparison functor.
+ *  @param  pool    Thread pool which will be used for sorting.
+ *  @return  Nothing.
+ *
+ *  The same as above, but the buffer is taken from pool.scratch().
+*/
+template<typename RandomAccessIterator, typename Compare>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, mt::thread_pool& pool)
+{
+    scratch_buffer<typename std::iterator_traits<RandomAccessIterator>::value_type> buffer(pool.scratch(), std::distance(begin, end));
+    detail::stable_sort(begin, end, cmp, pool, buffer.begin());
+}
+
+/**
+ *  @brief Sort the elements of a sequence preserving the relative order of equivalent elements.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @param  threads_amount  Amount of thread which may be used for sorting.
+ *  @return  Nothing.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    mt::stable_sort(begin, end, cmp, pool);
+}
+
+/**
+ *  @brief Sort the elements of a sequence preserving the relative order of equivalent elements.
+ *  @param  begin           An iterator linked with first element.
+ *  @param  end             Another iterator linked with last element.
+ *  @param  cmp             A comparison functor.
+ *  @return  Nothing.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<typename RandomAccessIterator, typename Compare, typename = typename std::enable_if<!std::is_integral<Compare>::value>::type>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, Compare cmp)
+{
+    mt::stable_sort(begin, end, cmp, mt::default_pool());
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, mt::thread_pool& pool)
+{
+    mt::stable_sort(begin, end, Compare(), pool);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end, size_t threads_amount)
+{
+    mt::stable_sort(begin, end, Compare(), threads_amount);
+}
+
+template<typename RandomAccessIterator, typename Compare = std::less<typename std::iterator_traits<RandomAccessIterator>::value_type>>
+CONSTEXPR inline void stable_sort(RandomAccessIterator begin, RandomAccessIterator end)
+{
+    mt::stable_sort(begin, end, Compare(), mt::default_pool());
+}
+
+}
+
+#endif // MT_STABLE_SORT_HPP
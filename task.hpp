@@ -0,0 +1,183 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/task.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_TASK_HPP
+#define MT_TASK_HPP
+
+#include <cstddef>      // for std::max_align_t
+#include <new>          // for placement new
+#include <type_traits>  // for std::decay
+#include <utility>      // for std::forward
+
+// Amount of bytes which a callable may take to be stored without heap allocation
+#ifndef MT_TASK_STORAGE_SIZE
+#define MT_TASK_STORAGE_SIZE 64
+#endif
+
+namespace mt {
+
+/**
+ *  @brief Move-only wrapper of a callable without arguments.
+ *
+ *  Unlike std::function it doesn't require the callable to be copyable and
+ *  keeps it inside of the object while it fits into MT_TASK_STORAGE_SIZE
+ *  bytes (and can be moved without exceptions). Only bigger callables are
+ *  allocated on the heap.
+*/
+class task {
+public:
+    static const size_t storage_size = MT_TASK_STORAGE_SIZE;
+
+    task() noexcept {}
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+    task(task&& other) noexcept {
+        move_from(other);
+    }
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+    template<class Function, class = typename std::enable_if<!std::is_same<typename std::decay<Function>::type, task>::value>::type>
+    task(Function&& func) {
+        emplace(std::forward<Function>(func));
+    }
+    ~task() {
+        reset();
+    }
+
+    template<class Function>
+    void emplace(Function&& func) {
+        typedef typename std::decay<Function>::type F;
+        reset();
+        construct<F>(std::forward<Function>(func), std::integral_constant<bool, fits_inline<F>::value>());
+    }
+
+    void reset() noexcept {
+        if (ops) {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+    void operator()() {
+        ops->invoke(storage);
+    }
+
+    explicit operator bool() const noexcept {
+        return ops != nullptr;
+    }
+
+private:
+    struct operations {
+        void (*invoke)(void* storage);
+        void (*move)(void* from, void* to); // also destroys the source
+        void (*destroy)(void* storage);
+    };
+
+    template<class F>
+    struct fits_inline : std::integral_constant<bool,
+        sizeof(F) <= storage_size &&
+        alignof(F) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible<F>::value> {};
+
+    template<class F>
+    struct inline_operations {
+        static void invoke(void* storage) {
+            (*static_cast<F*>(storage))();
+        }
+        static void move(void* from, void* to) {
+            new (to) F(std::move(*static_cast<F*>(from)));
+            static_cast<F*>(from)->~F();
+        }
+        static void destroy(void* storage) {
+            static_cast<F*>(storage)->~F();
+        }
+        static const operations* get() {
+            static const operations ops {invoke, move, destroy};
+            return &ops;
+        }
+    };
+
+    template<class F>
+    struct heap_operations {
+        static void invoke(void* storage) {
+            (**static_cast<F**>(storage))();
+        }
+        static void move(void* from, void* to) {
+            *static_cast<F**>(to) = *static_cast<F**>(from);
+        }
+        static void destroy(void* storage) {
+            delete *static_cast<F**>(storage);
+        }
+        static const operations* get() {
+            static const operations ops {invoke, move, destroy};
+            return &ops;
+        }
+    };
+
+    alignas(std::max_align_t) unsigned char storage[storage_size];
+    const operations* ops {nullptr};
+
+    template<class F, class Function>
+    void construct(Function&& func, std::true_type) {
+        new (storage) F(std::forward<Function>(func));
+        ops = inline_operations<F>::get();
+    }
+
+    template<class F, class Function>
+    void construct(Function&& func, std::false_type) {
+        *reinterpret_cast<F**>(storage) = new F(std::forward<Function>(func));
+        ops = heap_operations<F>::get();
+    }
+
+    void move_from(task& other) noexcept {
+        if (other.ops) {
+            other.ops->move(other.storage, storage);
+            ops = other.ops;
+            other.ops = nullptr;
+        }
+    }
+};
+
+}
+
+#endif // MT_TASK_HPP
@@ -39,28 +39,181 @@
 #ifndef MT_THREAD_POOL_HPP
 #define MT_THREAD_POOL_HPP
 
+#include "task.hpp"
+#include "future.hpp"
+#include "topology.hpp"
+#include "scratch_arena.hpp"
+#ifdef MT_POOL_STATS
+#include "pool_stats.hpp"
+#endif
 #include <thread>       // for std::thread
 #include <mutex>        // for std::mutex
+#include <condition_variable> // for std::condition_variable
 #include <vector>       // for std::vector
-#include <queue>        // for std::queue
-#include <future>       // for std::packeged_task
+#include <algorithm>    // for std::min
+#include <future>       // for std::async
 #include <functional>   // for std::bind
 #include <type_traits>  // for std::result_of
 #include <atomic>       // for std::atomic
+#include <chrono>       // for std::chrono::steady_clock
+#include <cstdint>      // for uintptr_t
+#include <new>          // for ::operator new
 
 namespace mt {
 
+namespace detail {
+
+static const size_t cache_line_size = 64;
+
+/**
+ *  @brief Allocator which places every allocation at the beginning of a cache line.
+ *
+ *  C++11 doesn't guarantee that over-aligned types are aligned when they are
+ *  allocated by std::allocator, so containers of alignas(cache_line_size)
+ *  objects should use this one instead.
+*/
+template<class T>
+struct cache_aligned_allocator {
+    typedef T value_type;
+
+    cache_aligned_allocator() noexcept {}
+    template<class U> cache_aligned_allocator(const cache_aligned_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        // Keep original pointer right before the aligned block to be able to release it
+        char* raw = static_cast<char*>(::operator new(n * sizeof(T) + cache_line_size + sizeof(void*)));
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void*) + cache_line_size - 1) & ~(uintptr_t)(cache_line_size - 1);
+        reinterpret_cast<void**>(aligned)[-1] = raw;
+        return reinterpret_cast<T*>(aligned);
+    }
+    void deallocate(T* p, size_t) noexcept {
+        ::operator delete(reinterpret_cast<void**>(p)[-1]);
+    }
+};
+
+template<class T, class U>
+inline bool operator==(const cache_aligned_allocator<T>&, const cache_aligned_allocator<U>&) { return true; }
+template<class T, class U>
+inline bool operator!=(const cache_aligned_allocator<T>&, const cache_aligned_allocator<U>&) { return false; }
+
+}
+
+/**
+ *  How workers of mt::thread_pool are placed on CPUs.
+*/
+enum class affinity {
+    none,   // threads are not pinned (default)
+    cores,  // every worker is pinned to its own CPU, workers are split between NUMA nodes in equal blocks
+};
+
+// Default time which an idle worker spins for before it yields and parks
+#ifndef MT_POOL_SPIN_MICROSECONDS
+#define MT_POOL_SPIN_MICROSECONDS 50
+#endif
+
+// Default amount of std::this_thread::yield() calls of an idle worker before it parks
+#ifndef MT_POOL_IDLE_YIELDS
+#define MT_POOL_IDLE_YIELDS 16
+#endif
+
+/**
+ *  @brief What a worker of mt::thread_pool does when it has no tasks.
+ *
+ *  It spins with the pause instruction for @p spin, then yields @p yields
+ *  times and then parks until a task is pushed. Fine-grained bursty work
+ *  (e.g. leaves of mt::sort) gets the next task without sleep and wake-up
+ *  latency. The default policy is @p automatic: spinning and yielding are
+ *  skipped if the pool has as many threads as hardware threads or more,
+ *  they would take time from threads which do the work then. A policy
+ *  which is constructed from its values is always used as it is.
+*/
+struct idle_policy {
+    std::chrono::microseconds spin;
+    size_t yields;
+    bool automatic;
+
+    idle_policy() : spin(MT_POOL_SPIN_MICROSECONDS), yields(MT_POOL_IDLE_YIELDS), automatic(true) {}
+    idle_policy(std::chrono::microseconds spin, size_t yields) : spin(spin), yields(yields), automatic(false) {}
+};
+
+namespace detail {
+
+inline void cpu_relax()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#endif
+}
+
+}
+
 // See alternative option: https://stackoverflow.com/questions/53014805/add-a-stdpackaged-task-to-an-existing-thread
+//
+// Every worker owns a deque of tasks. Tasks pushed from a worker go to its own
+// deque and are taken back in LIFO order, so nested tasks (e.g. recursive
+// mt::sort) stay on the same core. Tasks pushed from other threads go to the
+// shared injection queue. Idle workers take tasks from the injection queue and
+// steal the oldest tasks (FIFO) from other workers, ones of the same NUMA node
+// first if workers are pinned.
+//
+// Tasks are stored in nodes which are allocated by slabs and reused, so
+// pushing a task doesn't allocate memory while its callable fits into
+// mt::task::storage_size bytes. Algorithms take their temporary buffers from
+// scratch(), so repeated calls on the same pool don't allocate them again.
+//
+// With MT_POOL_STATS defined every worker counts its tasks, steals, busy,
+// idle and parked time and push-to-start latencies, see stats(), and spans
+// of tasks can be recorded as a Chrome trace, see start_trace().
 class thread_pool {
 public:
     thread_pool(thread_pool&) = delete;
     thread_pool& operator=(thread_pool&) = delete;
     thread_pool(thread_pool&&) = delete; // TODO
     thread_pool& operator=(thread_pool&&) = delete; // TODO
-    thread_pool(size_t threads_amount = std::thread::hardware_concurrency()) {
+    /**
+     *  @param  threads_amount  Amount of workers.
+     *  @param  affinity        Placement of workers on CPUs, see mt::affinity.
+     *  @param  idle            What workers do when they have no tasks, see mt::idle_policy.
+    */
+    thread_pool(size_t threads_amount = std::thread::hardware_concurrency(), mt::affinity affinity = mt::affinity::none,
+                const mt::idle_policy& idle = mt::idle_policy())
+        : queues(threads_amount ? threads_amount : 1), worker_nodes(queues.size(), 0), steal_orders(queues.size()),
+#ifdef MT_POOL_STATS
+          stats_slots(queues.size() + 1),
+#endif
+          idle(idle) {
+        const size_t amount = queues.size();
+        // a spinning worker would take a hardware thread from a thread which pushes tasks
+        if (idle.automatic && amount >= std::thread::hardware_concurrency()) {
+            this->idle = mt::idle_policy(std::chrono::microseconds(0), 0);
+        }
+        std::vector<int> cpus(amount, -1);
+        if (affinity == mt::affinity::cores) {
+            const cpu_topology& topology = mt::system_topology();
+            numa_nodes = topology.nodes.size();
+            std::vector<size_t> placed(numa_nodes, 0);
+            for (size_t i = 0; i < amount; i++) {
+                const size_t node = i * numa_nodes / amount;
+                const std::vector<unsigned>& node_cpus = topology.nodes[node];
+                worker_nodes[i] = node;
+                cpus[i] = static_cast<int>(node_cpus[placed[node]++ % node_cpus.size()]);
+            }
+        }
+
+        // Workers of the same node are robbed first, every worker starts from its neighbour
+        for (size_t i = 0; i < amount; i++) {
+            for (size_t local = 0; local < 2; local++) {
+                for (size_t j = 1; j < amount; j++) {
+                    const size_t victim = (i + j) % amount;
+                    if ((worker_nodes[victim] == worker_nodes[i]) == (local == 0)) steal_orders[i].push_back(victim);
+                }
+            }
+        }
+
         // Initialise all worker threads
-        for (size_t i = 0; i < threads_amount; i++) {
-            threads.push_back(std::async(std::launch::async, [&]{worker();}));
+        for (size_t i = 0; i < amount; i++) {
+            const int cpu = cpus[i];
+            threads.push_back(std::async(std::launch::async, [this, i, cpu]{worker(i, cpu);}));
         }
     }
     ~thread_pool() {
@@ -71,89 +224,640 @@ public:
         shutdown_request = true;
 
         // Wake up all workers to let them finish processing
-        queue_cv.notify_all();
+        for (worker_queue& queue: queues) {
+            wake(queue);
+        }
 
         // Wait until all threads will be finished
+        threads.clear();
+
+        // All nodes are free now
+        detail::cache_aligned_allocator<task_node> allocator;
+        for (task_node* slab: slabs) {
+            for (size_t i = 0; i < slab_size; i++) {
+                slab[i].~task_node();
+            }
+            allocator.deallocate(slab, slab_size);
+        }
     }
-#ifdef MT_POOL_RET_SUPPORT // slower
-    // Note: you also need to replace "std::queue<std::function<void()>> task_queue;" with "std::queue<std::packaged_task<void()>> task_queue;".
+    /**
+     *  @brief Push a task and get its result later.
+     *  @param  func  A callable.
+     *  @param  args  Arguments which will be passed to @p func.
+     *  @return  mt::future which will hold the value returned by @p func.
+     *
+     *  Exception thrown by @p func is passed to the future as well.
+    */
     template<class Function, class... Args, class R = typename std::result_of<Function(Args...)>::type>
-    std::future<R> push(Function&& func, Args&&... args) {
-        std::packaged_task<R()> task(std::bind(std::forward<Function>(func), std::forward<Args>(args)...));
-        auto result = task.get_future();
-
-        // Note: that the lambda takes it by reference, because it's actually stored in the bind object.
-        add(std::packaged_task<void()>(std::bind([](std::packaged_task<R()>& task){task();}, std::move(task))));
-        return result;
+    mt::future<R> submit(Function&& func, Args&&... args) {
+        typedef decltype(std::bind(std::forward<Function>(func), std::forward<Args>(args)...)) bound;
+        auto state = new typename mt::future<R>::state_type();
+        add(detail::future_task<R, bound>(state, std::bind(std::forward<Function>(func), std::forward<Args>(args)...)));
+        return mt::future<R>(state);
+    }
+#ifdef MT_POOL_RET_SUPPORT // kept for compatibility, the same as submit()
+    template<class Function, class... Args, class R = typename std::result_of<Function(Args...)>::type>
+    mt::future<R> push(Function&& func, Args&&... args) {
+        return submit(std::forward<Function>(func), std::forward<Args>(args)...);
     }
-#else // faster
+#else
     template<class Function, class... Args>
     void push(Function&& func, Args&&... args) {
         add(std::bind(std::forward<Function>(func), std::forward<Args>(args)...));
     }
 #endif
+    // Waits until the pool has no tasks at all. Use mt::task_group to wait for particular tasks only.
     void wait() {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        if (!task_queue.empty() || active > 0) {
+        std::unique_lock<std::mutex> lock(wait_mutex);
+        while (unfinished != 0) {
             wait_cv.wait(lock);
         }
     }
 
+    size_t size() const {
+        return queues.size();
+    }
+
+    // The idle policy which workers follow, the automatic one is resolved for the amount of workers
+    const mt::idle_policy& get_idle_policy() const {
+        return idle;
+    }
+
+    // Approximate number of threads which are waiting for tasks now, they will run a pushed task at once
+    size_t idle_amount() const {
+        return idle_workers + sleepers;
+    }
+
+    // Amount of NUMA nodes which workers are pinned to, it is 1 if they are not pinned
+    size_t nodes_amount() const {
+        return numa_nodes;
+    }
+
+    // NUMA node of a worker, an index in mt::system_topology().nodes
+    size_t node_of(size_t worker) const {
+        return worker_nodes[worker];
+    }
+
+    // Scratch memory of algorithms which run on the pool, see mt::scratch_arena
+    scratch_arena& scratch() {
+        return *arena;
+    }
+
+    // Algorithms on the pool will take scratch memory from @p shared, which must outlive the pool
+    void use_scratch(scratch_arena& shared) {
+        arena = &shared;
+    }
+
+#ifdef MT_POOL_STATS
+    // Counters of every worker and of helpers, see mt::pool_stats. Only with MT_POOL_STATS defined.
+    pool_stats stats() const {
+        pool_stats result;
+        for (size_t i = 0; i < queues.size(); i++) result.workers.push_back(stats_slots[i].snapshot());
+        result.helpers = stats_slots.back().snapshot();
+        return result;
+    }
+
+    void reset_stats() {
+        for (detail::stats_slot& slot: stats_slots) slot.reset();
+    }
+
+    // Spans of tasks which start after this call are recorded, the previous ones are dropped
+    void start_trace() {
+        for (detail::stats_slot& slot: stats_slots) {
+            std::lock_guard<std::mutex> lock(slot.trace_mutex);
+            slot.trace.clear();
+        }
+        trace_start = std::chrono::steady_clock::now();
+        tracing.store(true, std::memory_order_release);
+    }
+
+    void stop_trace() {
+        tracing = false;
+    }
+
+    // Recorded spans of tasks ordered by their start
+    std::vector<trace_event> trace() const {
+        std::vector<trace_event> result;
+        for (const detail::stats_slot& slot: stats_slots) {
+            std::lock_guard<std::mutex> lock(slot.trace_mutex);
+            result.insert(result.end(), slot.trace.begin(), slot.trace.end());
+        }
+        std::sort(result.begin(), result.end(), [](const trace_event& a, const trace_event& b) { return a.start < b.start; });
+        return result;
+    }
+
+    // Writes recorded spans as a Chrome trace, see mt::write_chrome_trace()
+    void write_trace(std::ostream& out) const {
+        write_chrome_trace(out, trace());
+    }
+#endif
+
 private:
-    std::vector<std::future<void>> threads;
-    std::queue<std::function<void()>> task_queue;
-    std::mutex queue_mutex;
-    std::condition_variable queue_cv;
+    friend class task_group;
+
+    struct alignas(detail::cache_line_size) task_node {
+        task_node* prev {nullptr};
+        task_node* next {nullptr};
+        mt::task work;
+#ifdef MT_POOL_STATS
+        std::chrono::steady_clock::time_point pushed;
+#endif
+    };
+
+    struct alignas(detail::cache_line_size) worker_queue {
+        std::mutex mutex;
+        task_node* head {nullptr}; // the oldest task
+        task_node* tail {nullptr}; // the newest task
+#ifdef MT_POOL_STATS
+        size_t depth {0};
+#endif
+
+        // Free nodes cache, it is used by the owner only
+        alignas(detail::cache_line_size) task_node* free_nodes {nullptr};
+        size_t free_amount {0};
+
+        // The owner waits here for tasks, it is woken up by the first one who resets parked
+        alignas(detail::cache_line_size) std::atomic<bool> parked {false};
+        std::mutex park_mutex;
+        std::condition_variable park_cv;
+    };
+
+    struct worker_context {
+        thread_pool* pool;
+        size_t index;
+    };
+
+    static const size_t slab_size = 64; // nodes
+    static const size_t free_nodes_limit = 4 * slab_size; // per worker
+
+    static const size_t any_worker = size_t(-1);
+
+    std::vector<worker_queue, detail::cache_aligned_allocator<worker_queue>> queues;
+    std::vector<size_t> worker_nodes;
+    std::vector<std::vector<size_t>> steal_orders; // other workers in order of stealing
+#ifdef MT_POOL_STATS
+    std::vector<detail::stats_slot, detail::cache_aligned_allocator<detail::stats_slot>> stats_slots; // workers, then helpers
+    std::atomic<bool> tracing {false};
+    std::chrono::steady_clock::time_point trace_start;
+#endif
+    size_t numa_nodes {1};
+    worker_queue injection_queue;
+    alignas(detail::cache_line_size) std::atomic<size_t> pending {0};    // tasks in all queues
+    std::atomic<size_t> unfinished {0}; // tasks which have been pushed but not completed yet
+    std::atomic<size_t> parked_workers {0};
+    std::atomic<size_t> idle_workers {0}; // spinning, yielding or parked
+    std::atomic<size_t> sleepers {0};     // threads which wait for a task_group in help_until()
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_cv;
+    std::mutex wait_mutex;
     std::condition_variable wait_cv;
-    volatile bool shutdown_request {false};
-    std::atomic<std::size_t> active {0};
+    std::atomic<bool> shutdown_request {false};
+    mt::idle_policy idle;
+    std::mutex slab_mutex;
+    std::vector<task_node*> slabs;  // guarded by slab_mutex
+    task_node* free_nodes {nullptr}; // guarded by slab_mutex
+    std::vector<std::future<void>> threads;
+    scratch_arena own_scratch;
+    scratch_arena* arena {&own_scratch};
 
-    void add(std::function<void()>&& task) {
-        // Mutual exclusion lock ownership must be acquired first
-        std::lock_guard<std::mutex> lock(queue_mutex);
+    static worker_context& current() {
+        static thread_local worker_context context {nullptr, 0};
+        return context;
+    }
 
-        // Add task into queue
-        task_queue.emplace(std::forward<std::function<void()>>(task));
+#ifdef MT_POOL_STATS
+    // Counters of the current thread
+    detail::stats_slot& own_slot() {
+        worker_context& context = current();
+        return context.pool == this ? stats_slots[context.index] : stats_slots.back();
+    }
+#endif
+
+    // Takes up to @p amount free nodes from the shared list or allocates a new slab.
+    // slab_mutex must be locked.
+    task_node* take_free_nodes(size_t amount, size_t& taken) {
+        if (!free_nodes) {
+            task_node* slab = detail::cache_aligned_allocator<task_node>().allocate(slab_size);
+            for (size_t i = 0; i < slab_size; i++) {
+                new (&slab[i]) task_node();
+                slab[i].next = i + 1 < slab_size ? &slab[i + 1] : nullptr;
+            }
+            slabs.push_back(slab);
+            free_nodes = slab;
+        }
+
+        task_node* first = free_nodes;
+        task_node* last = first;
+        for (taken = 1; taken < amount && last->next; taken++) {
+            last = last->next;
+        }
+        free_nodes = last->next;
+        last->next = nullptr;
+        return first;
+    }
+
+    task_node* acquire_node() {
+        worker_context& context = current();
+        if (context.pool != this) {
+            std::lock_guard<std::mutex> lock(slab_mutex);
+            size_t taken;
+            return take_free_nodes(1, taken);
+        }
 
-        // Send out signal to indicate that task has been added
-        // If a thread is blocked because the task queue is empty, there will be a wake-up call.
-        // If not, do nothing.
-        queue_cv.notify_one();
+        worker_queue& queue = queues[context.index];
+        if (!queue.free_nodes) {
+            std::lock_guard<std::mutex> lock(slab_mutex);
+            queue.free_nodes = take_free_nodes(slab_size, queue.free_amount);
+        }
+        task_node* node = queue.free_nodes;
+        queue.free_nodes = node->next;
+        queue.free_amount--;
+        node->next = nullptr;
+        return node;
     }
 
-    void worker() {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+    // Called by workers only
+    void release_node(worker_queue& queue, task_node* node) {
+        node->next = queue.free_nodes;
+        queue.free_nodes = node;
+        queue.free_amount++;
+
+        // Give nodes back if this worker mostly executes tasks pushed by others
+        if (queue.free_amount > free_nodes_limit) {
+            task_node* last = queue.free_nodes;
+            for (size_t i = 1; i < free_nodes_limit / 2; i++) {
+                last = last->next;
+            }
+            std::lock_guard<std::mutex> lock(slab_mutex);
+            std::swap(last->next, free_nodes);
+            std::swap(queue.free_nodes, free_nodes);
+            queue.free_amount -= free_nodes_limit / 2;
+        }
+    }
+
+    // A task is put into the queue of @p worker if it is set
+    template<class Function>
+    void add(Function&& func, size_t worker = any_worker) {
+        task_node* node = acquire_node();
+        node->work.emplace(std::forward<Function>(func));
+
+        // Task must be accounted before somebody is able to complete it
+        unfinished++;
+        pending++;
+
+        // Nested tasks stay at the worker which has created them
+        worker_context& context = current();
+        worker_queue& queue = worker < queues.size() ? queues[worker] : context.pool == this ? queues[context.index] : injection_queue;
+#ifdef MT_POOL_STATS
+        node->pushed = std::chrono::steady_clock::now();
+        size_t depth;
+#endif
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            node->prev = queue.tail;
+            if (queue.tail) {
+                queue.tail->next = node;
+            } else {
+                queue.head = node;
+            }
+            queue.tail = node;
+#ifdef MT_POOL_STATS
+            depth = ++queue.depth;
+#endif
+        }
+#ifdef MT_POOL_STATS
+        stats_slots[&queue == &injection_queue ? queues.size() : size_t(&queue - queues.data())].update_depth(depth);
+#endif
+
+        // Wake up one parked worker or one sleeping helper. Spinning workers will see the task
+        // themselves, so nobody is notified if nobody sleeps
+        if (parked_workers != 0 && wake_any()) return;
+        if (sleepers != 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            sleep_cv.notify_one();
+        }
+    }
+
+    // Wakes up the owner of the queue if it is parked
+    bool wake(worker_queue& queue) {
+        if (!queue.parked.exchange(false)) return false;
+        parked_workers--;
+        std::lock_guard<std::mutex> lock(queue.park_mutex);
+        queue.park_cv.notify_one();
+        return true;
+    }
+
+    bool wake_any() {
+        worker_context& context = current();
+        const size_t first = context.pool == this ? context.index + 1 : 0;
+        for (size_t i = 0; i < queues.size(); i++) {
+            if (wake(queues[(first + i) % queues.size()])) return true;
+        }
+        return false;
+    }
+
+    // Spins, yields and parks according to the idle policy until a task is pushed or the pool is destroyed
+    void wait_for_tasks(worker_queue& queue) {
+        const auto spin_end = std::chrono::steady_clock::now() + idle.spin;
+        for (size_t round = 0; idle.spin.count() > 0; round++) {
+            if (pending != 0 || shutdown_request) return;
+            detail::cpu_relax();
+            if (round % 64 == 63 && std::chrono::steady_clock::now() >= spin_end) break;
+        }
+        for (size_t i = 0; i < idle.yields; i++) {
+            if (pending != 0 || shutdown_request) return;
+            std::this_thread::yield();
+        }
+
+        queue.parked = true;
+        parked_workers++;
+        // A task pushed before parked was set is seen here, one pushed after it wakes the worker up
+        if (pending != 0 || shutdown_request) {
+            if (queue.parked.exchange(false)) parked_workers--;
+            return;
+        }
+        std::unique_lock<std::mutex> lock(queue.park_mutex);
+#ifdef MT_POOL_STATS
+        const auto park_start = std::chrono::steady_clock::now();
+#endif
+        while (queue.parked) {
+            queue.park_cv.wait(lock);
+        }
+#ifdef MT_POOL_STATS
+        detail::stats_slot& slot = own_slot();
+        slot.add(slot.parked, std::chrono::steady_clock::now() - park_start);
+#endif
+    }
+
+    task_node* pop(worker_queue& queue, bool lifo) {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        task_node* node = lifo ? queue.tail : queue.head;
+        if (!node) return nullptr;
+        if (lifo) {
+            queue.tail = node->prev;
+            (queue.tail ? queue.tail->next : queue.head) = nullptr;
+        } else {
+            queue.head = node->next;
+            (queue.head ? queue.head->prev : queue.tail) = nullptr;
+        }
+        node->prev = node->next = nullptr;
+        pending--;
+#ifdef MT_POOL_STATS
+        queue.depth--;
+#endif
+        return node;
+    }
+
+    task_node* try_pop() {
+        worker_context& context = current();
+        const bool is_worker = context.pool == this;
+
+        // Own tasks first (the most recent one is the hottest in cache)
+        if (is_worker) {
+            if (task_node* node = pop(queues[context.index], true)) return node;
+        }
+
+        // Don't touch shared state if there is nothing to get
+        if (pending == 0) return nullptr;
+
+        // Then tasks pushed from outside and the oldest tasks of other workers (the biggest ones)
+        if (task_node* node = pop(injection_queue, false)) return node;
+        if (is_worker) {
+            for (size_t victim: steal_orders[context.index]) {
+                if (task_node* node = pop(queues[victim], false)) return stolen(node);
+            }
+        } else {
+            for (worker_queue& queue: queues) {
+                if (task_node* node = pop(queue, false)) return stolen(node);
+            }
+        }
+        return nullptr;
+    }
+
+    // Counts a task taken from a queue of another worker
+    task_node* stolen(task_node* node) {
+#ifdef MT_POOL_STATS
+        detail::stats_slot& slot = own_slot();
+        slot.add(slot.steals, 1);
+#endif
+        return node;
+    }
+
+    void execute(task_node* node) {
+#ifdef MT_POOL_STATS
+        detail::stats_slot& slot = own_slot();
+        const auto start = std::chrono::steady_clock::now();
+        slot.add_latency(start - node->pushed);
+#endif
+        node->work();
+        node->work.reset();
+#ifdef MT_POOL_STATS
+        const auto end = std::chrono::steady_clock::now();
+        slot.add(slot.tasks, 1);
+        slot.add(slot.busy, end - start);
+        if (tracing.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(slot.trace_mutex);
+            slot.trace.push_back(trace_event {size_t(&slot - stats_slots.data()), start - trace_start, end - start});
+        }
+#endif
+
+        worker_context& context = current();
+        if (context.pool == this) {
+            release_node(queues[context.index], node);
+        } else {
+            std::lock_guard<std::mutex> lock(slab_mutex);
+            node->next = free_nodes;
+            free_nodes = node;
+        }
+
+        // Let waiting threads know that all tasks are complete
+        if (--unfinished == 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            wait_cv.notify_all();
+        }
+    }
+
+    // Runs pending tasks in the current thread until @p done returns true.
+    // If there is nothing to run, the thread sleeps as idle workers do.
+    template<class Predicate>
+    void help_until(Predicate done) {
+        while (!done()) {
+            if (task_node* node = try_pop()) {
+                execute(node);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleepers++;
+#ifdef MT_POOL_STATS
+            const auto sleep_start = std::chrono::steady_clock::now();
+#endif
+            while (pending == 0 && !done()) {
+                sleep_cv.wait(lock);
+            }
+#ifdef MT_POOL_STATS
+            detail::stats_slot& slot = own_slot();
+            slot.add(slot.parked, std::chrono::steady_clock::now() - sleep_start);
+#endif
+            sleepers--;
+        }
+    }
+
+    // Wakes up threads sleeping in help_until() to let them check their condition
+    void notify_helpers() {
+        if (sleepers != 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            sleep_cv.notify_all();
+        }
+    }
+
+    void worker(size_t index, int cpu) {
+        current() = worker_context {this, index};
+        if (cpu >= 0) detail::pin_current_thread(static_cast<unsigned>(cpu));
 
         while (true) {
             // Process all available tasks
-            active++;
-            while (!task_queue.empty()) {
-                // Get task from queue while mutex is still locked
-                auto task = std::move(task_queue.front());
-                task_queue.pop();
-
-                // Release mutex for to let task be running without locking other threads
-                queue_mutex.unlock();
-                task();
-                queue_mutex.lock();
+            while (task_node* node = try_pop()) {
+                execute(node);
             }
-            active--;
 
-            // Let waiting threads know that all tasks are complete
-            if (active == 0) {
-                wait_cv.notify_all();
+            if (shutdown_request && pending == 0) {
+                return;
             }
 
-            if (shutdown_request) {
-                return; // note: mutex will be released automatically
-            }
+            idle_workers++;
+#ifdef MT_POOL_STATS
+            detail::stats_slot& slot = stats_slots[index];
+            const auto wait_start = std::chrono::steady_clock::now();
+            const int64_t parked_before = slot.parked.load(std::memory_order_relaxed);
+#endif
+            wait_for_tasks(queues[index]);
+#ifdef MT_POOL_STATS
+            // the parked part of the wait has been counted separately
+            const int64_t parked = slot.parked.load(std::memory_order_relaxed) - parked_before;
+            slot.add(slot.idle, std::chrono::steady_clock::now() - wait_start - std::chrono::nanoseconds(parked));
+#endif
+            idle_workers--;
+        }
+    }
+};
+
+/**
+ *  @brief Process-wide thread pool.
+ *  @return  Reference to the pool.
+ *
+ *  The pool is created on the first call with one thread per hardware
+ *  thread and is shared by all algorithms which haven't got a pool or
+ *  amount of threads explicitly.
+*/
+inline thread_pool& default_pool()
+{
+    static thread_pool pool;
+    return pool;
+}
+
+/**
+ *  @brief Set of tasks which can be waited for independently of other tasks of the pool.
+ *
+ *  Tasks are added by run(), including tasks which are added by other tasks
+ *  of the same group. wait() returns when all of them are complete, so
+ *  several groups (e.g. several mt::sort calls) can share one pool. While
+ *  waiting, the thread executes pending tasks of the pool instead of
+ *  blocking, so it is allowed to wait for a group inside of a task.
+*/
+class task_group {
+public:
+    task_group(task_group&) = delete;
+    task_group& operator=(task_group&) = delete;
+    explicit task_group(thread_pool& pool = default_pool()) : pool(pool) {}
+    ~task_group() {
+        // Tasks refer to the group, so it can't be destroyed before them
+        pool.help_until([this]{ return unfinished == 0; });
+    }
 
-            // The task queue is empty and shutdown request hasn't been received
-            queue_cv.wait(lock);
+    template<class Function, class... Args>
+    void run(Function&& func, Args&&... args) {
+        typedef decltype(std::bind(std::forward<Function>(func), std::forward<Args>(args)...)) bound;
+        unfinished++;
+        pool.add(group_task<bound>(this, std::bind(std::forward<Function>(func), std::forward<Args>(args)...)));
+    }
+
+    /**
+     *  @brief Wait until all tasks of the group are complete.
+     *
+     *  Rethrows the first exception thrown by a task of the group.
+    */
+    void wait() {
+        pool.help_until([this]{ return unfinished == 0; });
+        if (error) {
+            std::exception_ptr e;
+            std::swap(e, error);
+            std::rethrow_exception(e);
         }
     }
+
+    /**
+     *  @brief Add a task which prefers to run on the given worker of the pool.
+     *
+     *  It is a hint for data which was first touched by the same worker (all
+     *  algorithms split ranges by detail::home_worker()), its pages are on the
+     *  node of the worker then. The task is put into the queue of the worker
+     *  only if workers are pinned to several NUMA nodes, otherwise it is the
+     *  same as run(). Other workers can steal it anyway.
+    */
+    template<class Function, class... Args>
+    void run_at(size_t worker, Function&& func, Args&&... args) {
+        typedef decltype(std::bind(std::forward<Function>(func), std::forward<Args>(args)...)) bound;
+        unfinished++;
+        pool.add(group_task<bound>(this, std::bind(std::forward<Function>(func), std::forward<Args>(args)...)),
+                 pool.nodes_amount() > 1 ? worker : size_t(thread_pool::any_worker));
+    }
+
+    thread_pool& get_pool() const {
+        return pool;
+    }
+
+private:
+    template<class Function>
+    struct group_task {
+        task_group* group;
+        Function func;
+
+        group_task(task_group* group, Function&& func) : group(group), func(std::move(func)) {}
+
+        void operator()() {
+            try {
+                func();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(group->error_mutex);
+                if (!group->error) group->error = std::current_exception();
+            }
+
+            // The group may be destroyed as soon as the counter reaches zero
+            thread_pool& pool = group->pool;
+            if (--group->unfinished == 0) {
+                pool.notify_helpers();
+            }
+        }
+    };
+
+    thread_pool& pool;
+    std::atomic<size_t> unfinished {0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
 };
 
+namespace detail {
+
+// Worker which processes the part of a range at @p offset when the range is split into equal parts by workers
+inline size_t home_worker(const thread_pool& pool, size_t offset, size_t size)
+{
+    const size_t part_size = (size + pool.size() - 1) / pool.size();
+    return part_size ? std::min(offset / part_size, pool.size() - 1) : 0;
+}
+
+}
+
 }
 
 #endif // MT_THREAD_POOL_HPP
@@ -0,0 +1,155 @@
+/*
+ * Multithread library
+ *
+ * MIT License
+ *
+ * Copyright (c) 2021 Alex Dolzhenkov
+ * All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/** @file mt/topology.hpp
+ *
+ * @brief The main aim of this library is implementation standard function using
+ * multithread algorithms. Also it allows to implement your self multithread
+ * algorithms more easy.
+ *
+ * @note This library required modern C++11 or higher
+ *
+ * @author Alex Dolzhenkov
+ */
+
+#ifndef MT_TOPOLOGY_HPP
+#define MT_TOPOLOGY_HPP
+
+#include <algorithm>    // for std::max
+#include <cstdlib>      // for strtoul
+#include <fstream>      // for std::ifstream
+#include <string>       // for std::string
+#include <thread>       // for std::thread::hardware_concurrency
+#include <vector>       // for std::vector
+#ifdef __linux__
+#include <pthread.h>    // for pthread_setaffinity_np
+#include <sched.h>      // for sched_getaffinity
+#endif
+
+namespace mt {
+
+/**
+ *  @brief NUMA nodes with CPUs which the process is allowed to run on.
+ *
+ *  On Linux it is read from /sys/devices/system/node, otherwise or if it
+ *  isn't available all hardware threads are considered to be one node.
+*/
+struct cpu_topology {
+    std::vector<std::vector<unsigned>> nodes; // CPUs of every node which has allowed ones
+};
+
+namespace detail {
+
+// Parses lists like "0-3,8,10-11" from sysfs
+inline std::vector<unsigned> parse_cpu_list(const std::string& list)
+{
+    std::vector<unsigned> result;
+    const char* p = list.c_str();
+    while (*p) {
+        char* next;
+        const unsigned long first = strtoul(p, &next, 10);
+        if (next == p) break;
+        unsigned long last = first;
+        p = next;
+        if (*p == '-') {
+            last = strtoul(p + 1, &next, 10);
+            p = next;
+        }
+        for (unsigned long cpu = first; cpu <= last; cpu++) result.push_back(static_cast<unsigned>(cpu));
+        if (*p == ',') p++;
+        else break;
+    }
+    return result;
+}
+
+inline cpu_topology discover_topology()
+{
+    cpu_topology topology;
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    const bool restricted = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    auto is_allowed = [&](unsigned cpu) { return !restricted || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)); };
+
+    std::string line;
+    std::ifstream online("/sys/devices/system/node/online");
+    if (std::getline(online, line)) {
+        for (unsigned node: detail::parse_cpu_list(line)) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::vector<unsigned> cpus;
+            if (std::getline(file, line)) {
+                for (unsigned cpu: detail::parse_cpu_list(line)) {
+                    if (is_allowed(cpu)) cpus.push_back(cpu);
+                }
+            }
+            if (!cpus.empty()) topology.nodes.push_back(cpus);
+        }
+    }
+    if (topology.nodes.empty() && restricted) {
+        std::vector<unsigned> cpus;
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+        if (!cpus.empty()) topology.nodes.push_back(cpus);
+    }
+#endif
+    if (topology.nodes.empty()) {
+        topology.nodes.push_back(std::vector<unsigned>());
+        for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1u); cpu++) {
+            topology.nodes.back().push_back(cpu);
+        }
+    }
+    return topology;
+}
+
+// Returns false if threads can't be pinned on this platform
+inline bool pin_current_thread(unsigned cpu)
+{
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+}
+
+// Topology of the machine, it is discovered once
+inline const cpu_topology& system_topology()
+{
+    static const cpu_topology topology = detail::discover_topology();
+    return topology;
+}
+
+}
+
+#endif // MT_TOPOLOGY_HPP
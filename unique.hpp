@@ -39,15 +39,18 @@
 #ifndef MT_UNIQUE_HPP
 #define MT_UNIQUE_HPP
 
+#include "thread_pool.hpp"
+#include "compact.hpp"
+#include "simd_unique.hpp"
 #include <vector>       // for std::vector
-#include <algorithm>    // for std::unique
+#include <algorithm>    // for std::unique, std::unique_copy
 #include <thread>       // for std::thread
 #include <future>       // for std::async
 #include <string.h>
 
 #ifndef CONSTEXPR
 #if __cplusplus >= 201703L
-#define CONSTEXPR contexpr
+#define CONSTEXPR constexpr
 #else
 #define CONSTEXPR
 #endif
@@ -55,37 +58,223 @@
 
 namespace mt {
 
+/**
+ *  @brief Remove consecutive values from a sequence using a predicate.
+ *  @param  begin  A forward iterator.
+ *  @param  end    A forward iterator.
+ *  @param  p      A binary predicate.
+ *  @param  pool   Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Removes all but the first element from each group of consecutive
+ *  values for which @p p returns true.
+ *
+ *  Every part of the sequence is processed by its own task, then kept
+ *  elements of all parts are moved to their final positions in parallel too.
+ *  Contiguous sequences of 32 and 64 bit integers compared by std::equal_to
+ *  are processed by AVX2 or AVX-512 kernels if the CPU supports them.
+*/
 template<class ForwardIt, class BinaryPredicate>
-CONSTEXPR inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate p, size_t threads_amount = std::thread::hardware_concurrency())
+CONSTEXPR inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate p, mt::thread_pool& pool)
 {
-    std::vector<std::future<ForwardIt>> threads;
-    size_t part_size = std::distance(begin, end) / threads_amount;
+    const size_t size = std::distance(begin, end);
+    const size_t parts_amount = std::max<size_t>(1, std::min(pool.size(), size));
+    const size_t part_size = size / parts_amount;
+    std::vector<ForwardIt> lasts(parts_amount);
+    mt::task_group group(pool);
 
-    for (size_t i = 0; i < threads_amount; i++) {
+    for (size_t i = 0; i < parts_amount; i++) {
         auto _begin = begin + part_size * i;
         auto _end = begin + part_size * (i + 1);
-        if (i == threads_amount - 1) _end = end;
-        threads.push_back(std::async(std::launch::async, [_begin, _end]{ return std::unique(_begin, _end); }));
+        if (i == parts_amount - 1) _end = end;
+        ForwardIt& _last = lasts[i];
+        group.run_at(detail::home_worker(pool, part_size * i, size), [_begin, _end, &_last, p]{ _last = detail::unique(_begin, _end, p); });
     }
+    group.wait();
 
-    auto last = threads[0].get();
-    for (size_t i = 1; i < threads_amount; i++) {
-        auto _begin = begin + part_size * i;
-        auto _last = threads[i].get();
-        if (p(*_begin, *(last - 1))) _begin++;
-        std::copy(_begin, _last, last);
-        last += std::distance(_begin, _last);
+    // the first element of a part is dropped if it is equal to the last kept element of previous parts
+    std::vector<detail::compact_range> kept(parts_amount);
+    kept[0] = {0, size_t(std::distance(begin, lasts[0]))};
+    ForwardIt last = lasts[0];
+    for (size_t i = 1; i < parts_amount; i++) {
+        size_t _begin = part_size * i;
+        if (p(*(last - 1), *(begin + _begin))) _begin++;
+        kept[i] = {_begin, size_t(std::distance(begin, lasts[i]))};
+        if (kept[i].begin != kept[i].end) last = lasts[i];
     }
-    return last;
+    return detail::parallel_compact(begin, kept, pool);
+}
+
+/**
+ *  @brief Remove consecutive values from a sequence using a predicate.
+ *  @param  begin           A forward iterator.
+ *  @param  end             A forward iterator.
+ *  @param  p               A binary predicate.
+ *  @param  threads_amount  Amount of thread which may be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<class ForwardIt, class BinaryPredicate, typename = typename std::enable_if<!std::is_integral<BinaryPredicate>::value>::type>
+CONSTEXPR inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate p, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    return mt::unique(begin, end, p, pool);
+}
+
+/**
+ *  @brief Remove consecutive values from a sequence using a predicate.
+ *  @param  begin  A forward iterator.
+ *  @param  end    A forward iterator.
+ *  @param  p      A binary predicate.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<class ForwardIt, class BinaryPredicate, typename = typename std::enable_if<!std::is_integral<BinaryPredicate>::value>::type>
+CONSTEXPR inline ForwardIt unique(ForwardIt begin, ForwardIt end, BinaryPredicate p)
+{
+    return mt::unique(begin, end, p, mt::default_pool());
 }
 
 
 template<class ForwardIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
-CONSTEXPR inline ForwardIt unique(ForwardIt first, ForwardIt last, size_t threads_amount = std::thread::hardware_concurrency())
+CONSTEXPR inline ForwardIt unique(ForwardIt first, ForwardIt last, mt::thread_pool& pool)
+{
+    return mt::unique(first, last, Pred(), pool);
+}
+
+template<class ForwardIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline ForwardIt unique(ForwardIt first, ForwardIt last, size_t threads_amount)
 {
     return mt::unique(first, last, Pred(), threads_amount);
 }
 
+template<class ForwardIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline ForwardIt unique(ForwardIt first, ForwardIt last)
+{
+    return mt::unique(first, last, Pred(), mt::default_pool());
+}
+
+
+/**
+ *  @brief Copy a sequence, removing consecutive duplicate values using a predicate.
+ *  @param  begin    A forward iterator.
+ *  @param  end      A forward iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  p        A binary predicate.
+ *  @param  pool     Thread pool which will be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  Copies all but the first element from each group of consecutive values
+ *  for which @p p returns true. Parts of the sequence count their kept
+ *  elements in parallel first, so every part is copied to its own offset
+ *  of the destination by its own task and nothing is moved twice.
+*/
+template<class ForwardIt, class RandomIt, class BinaryPredicate>
+CONSTEXPR inline RandomIt unique_copy(ForwardIt begin, ForwardIt end, RandomIt d_first, BinaryPredicate p, mt::thread_pool& pool)
+{
+    const size_t size = std::distance(begin, end);
+    const size_t parts_amount = std::max<size_t>(1, std::min(pool.size(), size));
+    const size_t part_size = size / parts_amount;
+    std::vector<ForwardIt> firsts(parts_amount); // the first kept element of every part
+    std::vector<size_t> offsets(parts_amount + 1);
+    mt::task_group group(pool);
+
+    for (size_t i = 0; i < parts_amount; i++) {
+        auto _begin = begin + part_size * i;
+        auto _end = begin + part_size * (i + 1);
+        if (i == parts_amount - 1) _end = end;
+        ForwardIt& _first = firsts[i];
+        size_t& _kept = offsets[i + 1];
+        group.run_at(detail::home_worker(pool, part_size * i, size), [begin, _begin, _end, &_first, &_kept, p]{
+            auto first = _begin;
+            // elements which are equal to the end of the previous part are dropped
+            if (first != begin) {
+                while (first != _end && p(*(first - 1), *first)) ++first;
+            }
+            size_t kept = 0;
+            if (first != _end) {
+                kept = 1;
+                for (auto it = first + 1; it != _end; ++it) {
+                    if (!p(*(it - 1), *it)) kept++;
+                }
+            }
+            _first = first;
+            _kept = kept;
+        });
+    }
+    group.wait();
+
+    for (size_t i = 0; i < parts_amount; i++) {
+        offsets[i + 1] += offsets[i];
+    }
+    for (size_t i = 0; i < parts_amount; i++) {
+        auto _first = firsts[i];
+        auto _end = i == parts_amount - 1 ? end : begin + part_size * (i + 1);
+        auto _to = d_first + offsets[i];
+        group.run_at(detail::home_worker(pool, part_size * i, size), [_first, _end, _to, p]{ std::unique_copy(_first, _end, _to, p); });
+    }
+    group.wait();
+    return d_first + offsets[parts_amount];
+}
+
+/**
+ *  @brief Copy a sequence, removing consecutive duplicate values using a predicate.
+ *  @param  begin           A forward iterator.
+ *  @param  end             A forward iterator.
+ *  @param  d_first         A random access iterator, the beginning of the destination.
+ *  @param  p               A binary predicate.
+ *  @param  threads_amount  Amount of thread which may be used for processing.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but a new pool of @p threads_amount threads is created
+ *  for this call.
+*/
+template<class ForwardIt, class RandomIt, class BinaryPredicate, typename = typename std::enable_if<!std::is_integral<BinaryPredicate>::value>::type>
+CONSTEXPR inline RandomIt unique_copy(ForwardIt begin, ForwardIt end, RandomIt d_first, BinaryPredicate p, size_t threads_amount)
+{
+    mt::thread_pool pool(threads_amount);
+    return mt::unique_copy(begin, end, d_first, p, pool);
+}
+
+/**
+ *  @brief Copy a sequence, removing consecutive duplicate values using a predicate.
+ *  @param  begin    A forward iterator.
+ *  @param  end      A forward iterator.
+ *  @param  d_first  A random access iterator, the beginning of the destination.
+ *  @param  p        A binary predicate.
+ *  @return  An iterator designating the end of the resulting sequence.
+ *
+ *  The same as above, but mt::default_pool() is used, so no threads are
+ *  created per call.
+*/
+template<class ForwardIt, class RandomIt, class BinaryPredicate, typename = typename std::enable_if<!std::is_integral<BinaryPredicate>::value>::type>
+CONSTEXPR inline RandomIt unique_copy(ForwardIt begin, ForwardIt end, RandomIt d_first, BinaryPredicate p)
+{
+    return mt::unique_copy(begin, end, d_first, p, mt::default_pool());
+}
+
+template<class ForwardIt, class RandomIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline RandomIt unique_copy(ForwardIt first, ForwardIt last, RandomIt d_first, mt::thread_pool& pool)
+{
+    return mt::unique_copy(first, last, d_first, Pred(), pool);
+}
+
+template<class ForwardIt, class RandomIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline RandomIt unique_copy(ForwardIt first, ForwardIt last, RandomIt d_first, size_t threads_amount)
+{
+    return mt::unique_copy(first, last, d_first, Pred(), threads_amount);
+}
+
+template<class ForwardIt, class RandomIt, typename Pred = std::equal_to<typename std::iterator_traits<ForwardIt>::value_type>>
+CONSTEXPR inline RandomIt unique_copy(ForwardIt first, ForwardIt last, RandomIt d_first)
+{
+    return mt::unique_copy(first, last, d_first, Pred(), mt::default_pool());
+}
+
 }
 
 #endif // MT_UNIQUE_HPP